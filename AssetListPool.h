@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+
+//Handle of an interned asset list. Two narrations referencing the same
+//assets get the same handle, so comparing lists is comparing handles.
+struct COLDWARPROJECT_API FAssetListHandle
+{
+	int32 m_Index = INDEX_NONE;
+
+	bool IsValid() const { return m_Index != INDEX_NONE; }
+	bool operator==(const FAssetListHandle& Other) const { return m_Index == Other.m_Index; }
+	bool operator!=(const FAssetListHandle& Other) const { return m_Index != Other.m_Index; }
+};
+
+//Asset lists of a narration, shared through the asset list pools.
+struct COLDWARPROJECT_API FNarrationAssetLists
+{
+	FAssetListHandle m_EnglishSounds;
+	FAssetListHandle m_FrenchSounds;
+	FAssetListHandle m_Images;
+};
+
+//Hash-consing pool of resolved asset lists. Each distinct list (same assets
+//in the same order) is stored once; interning a list already in the pool
+//returns the existing handle. The empty list is always handle 0. The owner
+//reports the assets to the garbage collector, and compacts the pool when a
+//tour is replaced so it only keeps the lists still referenced.
+template<typename T>
+class TAssetListPool
+{
+public:
+	TAssetListPool() { Reset(); }
+
+	void Reset();
+	FAssetListHandle Intern(const TArray<T*>& Assets);
+	void Compact(const TArray<FAssetListHandle*>& LiveHandles);
+	void AddReferencedObjects(FReferenceCollector& Collector);
+	const TArray<T*>& Get(FAssetListHandle Handle) const;
+	int32 Num() const { return m_Lists.Num(); }
+	int32 NumInterned() const { return m_NumInterned; }
+	SIZE_T GetAllocatedSize() const;
+	const TArray<TArray<T*>>& GetLists() const { return m_Lists; }
+
+private:
+	static uint32 HashList(const TArray<T*>& Assets);
+
+	TArray<TArray<T*>> m_Lists;
+	TMultiMap<uint32, int32> m_ListsByHash;
+	int32 m_NumInterned = 0;
+};
+
+template<typename T>
+void TAssetListPool<T>::Reset()
+{
+	m_Lists.Empty();
+	m_ListsByHash.Empty();
+	m_NumInterned = 0;
+	m_Lists.AddDefaulted();
+	m_ListsByHash.Add(HashList(m_Lists[0]), 0);
+}
+
+//Returns the handle of the list, adding it to the pool if it is new.
+template<typename T>
+FAssetListHandle TAssetListPool<T>::Intern(const TArray<T*>& Assets)
+{
+	m_NumInterned++;
+	const uint32 hash = HashList(Assets);
+
+	FAssetListHandle handle;
+	TArray<int32, TInlineAllocator<4>> candidates;
+	m_ListsByHash.MultiFind(hash, candidates);
+	for (int32 candidate : candidates)
+	{
+		if (m_Lists[candidate] == Assets)
+		{
+			handle.m_Index = candidate;
+			return handle;
+		}
+	}
+
+	handle.m_Index = m_Lists.Add(Assets);
+	m_ListsByHash.Add(hash, handle.m_Index);
+	return handle;
+}
+
+//Rebuilds the pool with the lists of the given handles only, and updates
+//the handles. The other lists and their assets are released.
+template<typename T>
+void TAssetListPool<T>::Compact(const TArray<FAssetListHandle*>& LiveHandles)
+{
+	TAssetListPool<T> compacted;
+	for (FAssetListHandle* handle : LiveHandles)
+	{
+		*handle = compacted.Intern(Get(*handle));
+	}
+	compacted.m_NumInterned = m_NumInterned;
+	*this = MoveTemp(compacted);
+}
+
+//Keeps the assets of the pool alive while lists reference them.
+template<typename T>
+void TAssetListPool<T>::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (TArray<T*>& list : m_Lists)
+	{
+		for (T*& asset : list)
+		{
+			Collector.AddReferencedObject(asset);
+		}
+	}
+}
+
+//Returns the list of a handle, or the empty list for an invalid handle.
+template<typename T>
+const TArray<T*>& TAssetListPool<T>::Get(FAssetListHandle Handle) const
+{
+	return m_Lists.IsValidIndex(Handle.m_Index) ? m_Lists[Handle.m_Index] : m_Lists[0];
+}
+
+template<typename T>
+SIZE_T TAssetListPool<T>::GetAllocatedSize() const
+{
+	SIZE_T size = m_Lists.GetAllocatedSize() + m_ListsByHash.GetAllocatedSize();
+	for (const TArray<T*>& list : m_Lists)
+	{
+		size += list.GetAllocatedSize();
+	}
+	return size;
+}
+
+template<typename T>
+uint32 TAssetListPool<T>::HashList(const TArray<T*>& Assets)
+{
+	uint32 hash = GetTypeHash(Assets.Num());
+	for (T* asset : Assets)
+	{
+		hash = HashCombine(hash, GetTypeHash(asset));
+	}
+	return hash;
+}
@@ -0,0 +1,54 @@
+#include "AssetNameResolver.h"
+
+/*************************************
+Class: FNameBloomFilter
+Author: Antoine Plouffe
+
+Description: Bloom filter used as the first check of the asset name
+resolution. With 10 bits per name and 7 hashes, about 1% of the unknown
+names get through to the name index. The hashes are derived from the
+case insensitive FString hash by double hashing.
+*************************************/
+
+void FNameBloomFilter::Reset(int32 NumNames)
+{
+	m_NumBits = FMath::Max<uint32>(64, FMath::RoundUpToPowerOfTwo(uint32(FMath::Max(NumNames, 1) * BitsPerName)));
+	m_Words.Init(0, m_NumBits / 64);
+}
+
+void FNameBloomFilter::Add(const FString& Name)
+{
+	uint32 hash1, hash2;
+	GetHashes(Name, hash1, hash2);
+	for (int32 i = 0; i < NumHashes; i++)
+	{
+		const uint32 bit = (hash1 + i * hash2) & (m_NumBits - 1);
+		m_Words[bit / 64] |= uint64(1) << (bit % 64);
+	}
+}
+
+bool FNameBloomFilter::MayContain(const FString& Name) const
+{
+	if (m_NumBits == 0)
+	{
+		return false;
+	}
+
+	uint32 hash1, hash2;
+	GetHashes(Name, hash1, hash2);
+	for (int32 i = 0; i < NumHashes; i++)
+	{
+		const uint32 bit = (hash1 + i * hash2) & (m_NumBits - 1);
+		if ((m_Words[bit / 64] & (uint64(1) << (bit % 64))) == 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void FNameBloomFilter::GetHashes(const FString& Name, uint32& OutHash1, uint32& OutHash2)
+{
+	OutHash1 = GetTypeHash(Name);
+	OutHash2 = HashCombine(OutHash1, 0x9e3779b9) | 1;
+}
@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+
+//Bloom filter over asset names (case insensitive, like FString comparison).
+//A name that was never added is rejected without touching the name index.
+class COLDWARPROJECT_API FNameBloomFilter
+{
+public:
+	void Reset(int32 NumNames);
+	void Add(const FString& Name);
+	bool MayContain(const FString& Name) const;
+	SIZE_T GetAllocatedSize() const { return m_Words.GetAllocatedSize(); }
+
+	static constexpr int32 BitsPerName = 10;
+	static constexpr int32 NumHashes = 7;
+
+private:
+	static void GetHashes(const FString& Name, uint32& OutHash1, uint32& OutHash2);
+
+	TArray<uint64> m_Words;
+	uint32 m_NumBits = 0;
+};
+
+//Name index of an asset array, replacing the scan of the whole array for
+//every requested name. Callers sync the index once per load, and it is
+//rebuilt only when the array changed. Unknown names are rejected by the
+//Bloom filter, and each of them is reported only once thanks to the
+//negative cache, which is kept across rebuilds.
+template<typename T>
+class TAssetNameResolver
+{
+public:
+	void Sync(const TArray<T*>& Assets);
+	bool Find(const FString& Name, TArray<T*>& OutAssets, bool& bOutIsFirstMiss);
+	bool MarkMissing(const FString& Name);
+	bool IsMissing(const FString& Name) const { return m_MissingNames.Contains(Name); }
+	void AddReferencedObjects(FReferenceCollector& Collector);
+	const TSet<FString>& GetMissingNames() const { return m_MissingNames; }
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	TArray<T*> m_IndexedAssets;
+	TMap<FString, TArray<T*, TInlineAllocator<1>>> m_AssetsByName;
+	FNameBloomFilter m_BloomFilter;
+	TSet<FString> m_MissingNames;
+};
+
+template<typename T>
+SIZE_T TAssetNameResolver<T>::GetAllocatedSize() const
+{
+	SIZE_T size = m_IndexedAssets.GetAllocatedSize() + m_AssetsByName.GetAllocatedSize() + m_BloomFilter.GetAllocatedSize() + m_MissingNames.GetAllocatedSize();
+	for (const auto& assets : m_AssetsByName)
+	{
+		size += assets.Key.GetAllocatedSize() + assets.Value.GetAllocatedSize();
+	}
+	for (const FString& name : m_MissingNames)
+	{
+		size += name.GetAllocatedSize();
+	}
+	return size;
+}
+
+//Rebuilds the index if the given array is not the one already indexed.
+//Comparing the pointers is much cheaper than comparing the names. Names
+//found in the new array leave the negative cache, the others stay in it
+//so they are not reported again when arrays alternate.
+template<typename T>
+void TAssetNameResolver<T>::Sync(const TArray<T*>& Assets)
+{
+	if (Assets.Num() == m_IndexedAssets.Num() && FMemory::Memcmp(Assets.GetData(), m_IndexedAssets.GetData(), Assets.Num() * sizeof(T*)) == 0)
+	{
+		return;
+	}
+
+	m_IndexedAssets = Assets;
+	m_AssetsByName.Empty(Assets.Num());
+	m_BloomFilter.Reset(Assets.Num());
+	for (T* asset : Assets)
+	{
+		if (asset)
+		{
+			const FString name = asset->GetName();
+			m_AssetsByName.FindOrAdd(name).Add(asset);
+			m_BloomFilter.Add(name);
+			m_MissingNames.Remove(name);
+		}
+	}
+}
+
+//Appends the assets with the given name, skipping the ones already in
+//OutAssets. Returns false for an unknown name; bOutIsFirstMiss tells the
+//caller to report it, which happens only the first time it is requested.
+template<typename T>
+bool TAssetNameResolver<T>::Find(const FString& Name, TArray<T*>& OutAssets, bool& bOutIsFirstMiss)
+{
+	bOutIsFirstMiss = false;
+	const auto* assets = m_BloomFilter.MayContain(Name) ? m_AssetsByName.Find(Name) : nullptr;
+	if (!assets)
+	{
+		bOutIsFirstMiss = MarkMissing(Name);
+		return false;
+	}
+
+	for (T* asset : *assets)
+	{
+		if (asset)
+		{
+			OutAssets.AddUnique(asset);
+		}
+	}
+	return true;
+}
+
+//Keeps the indexed assets alive, so the pointers compared by Sync and
+//returned by Find never dangle.
+template<typename T>
+void TAssetNameResolver<T>::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (T*& asset : m_IndexedAssets)
+	{
+		Collector.AddReferencedObject(asset);
+	}
+	for (auto& assets : m_AssetsByName)
+	{
+		for (T*& asset : assets.Value)
+		{
+			Collector.AddReferencedObject(asset);
+		}
+	}
+}
+
+//Adds a name to the negative cache. Returns true the first time,
+//when the caller should report it.
+template<typename T>
+bool TAssetNameResolver<T>::MarkMissing(const FString& Name)
+{
+	bool isAlreadyMissing;
+	m_MissingNames.Add(Name, &isAlreadyMissing);
+	return !isAlreadyMissing;
+}
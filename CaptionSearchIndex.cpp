@@ -0,0 +1,235 @@
+#include "CaptionSearchIndex.h"
+#include "GameData.h"
+#include "Internationalization/BreakIterator.h"
+#include "Internationalization/IBreakIterator.h"
+
+/*************************************
+Class: FCaptionSearchIndex
+Author: Antoine Plouffe
+
+Description: Search over the caption texts of the loaded checkpoints and
+learn more panels. Words are split with the word break rules of the active
+culture, then split again on apostrophes so the French elisions ("l'abri")
+index the word itself. Terms are lowercased for the active culture and the
+Latin-1 accents are removed, so "ecole" finds "École". A query word matches
+every term it prefixes; the documents of all the query words are combined
+in bitsets over the documents, which stays well under a millisecond for the
+few thousand terms of a tour.
+*************************************/
+
+namespace
+{
+	//Lowercase Latin-1 letters without their accent, 0 when kept as is.
+	const char Latin1Folds[] = "aaaaaa\0ceeeeiiii\0nooooo\0ouuuuy\0y";
+
+	bool IsApostrophe(TCHAR Char)
+	{
+		return Char == TEXT('\'') || Char == 0x2019;
+	}
+
+	void AppendFolded(TCHAR Char, FString& OutTerm)
+	{
+		if (Char >= 0xE0 && Char <= 0xFF && Latin1Folds[Char - 0xE0] != 0)
+		{
+			OutTerm.AppendChar(Latin1Folds[Char - 0xE0]);
+		}
+		else if (Char == 0xE6)
+		{
+			OutTerm += TEXT("ae");
+		}
+		else if (Char == 0x153)
+		{
+			OutTerm += TEXT("oe");
+		}
+		else
+		{
+			OutTerm.AppendChar(Char);
+		}
+	}
+
+	void AddToken(const FString& Word, TArray<FString>& OutTokens)
+	{
+		const FString lowercase = FText::AsCultureInvariant(Word).ToLower().ToString();
+		FString token;
+		token.Reserve(lowercase.Len());
+		bool hasLetterOrDigit = false;
+		for (TCHAR character : lowercase)
+		{
+			hasLetterOrDigit |= FChar::IsAlnum(character);
+			AppendFolded(character, token);
+		}
+		if (hasLetterOrDigit)
+		{
+			OutTokens.Add(MoveTemp(token));
+		}
+	}
+}
+
+//Splits a text in search terms.
+void FCaptionSearchIndex::Tokenize(const FString& Text, IBreakIterator& WordIterator, TArray<FString>& OutTokens)
+{
+	WordIterator.SetString(Text);
+	int32 begin = WordIterator.ResetToBeginning();
+	for (int32 end = WordIterator.MoveToNext(); end != INDEX_NONE; begin = end, end = WordIterator.MoveToNext())
+	{
+		int32 partBegin = begin;
+		for (int32 i = begin; i <= end; i++)
+		{
+			if (i == end || IsApostrophe(Text[i]))
+			{
+				if (i > partBegin)
+				{
+					AddToken(Text.Mid(partBegin, i - partBegin), OutTokens);
+				}
+				partBegin = i + 1;
+			}
+		}
+	}
+	WordIterator.ClearString();
+}
+
+//Builds the index of the given documents. Called on a worker thread.
+FCaptionSearchIndex FCaptionSearchIndex::Build(const TArray<FCaptionSearchDocument>& Documents)
+{
+	TSharedRef<IBreakIterator> wordIterator = FBreakIterator::CreateWordBreakIterator();
+	TMap<FString, TArray<int32>> postings;
+	TArray<FString> tokens;
+	for (int32 document = 0; document < Documents.Num(); document++)
+	{
+		tokens.Reset();
+		for (const FString& text : Documents[document].m_Texts)
+		{
+			Tokenize(text, *wordIterator, tokens);
+		}
+		for (const FString& token : tokens)
+		{
+			//Documents are added in order, so the postings stay sorted.
+			TArray<int32>& documents = postings.FindOrAdd(token);
+			if (documents.Num() == 0 || documents.Last() != document)
+			{
+				documents.Add(document);
+			}
+		}
+	}
+
+	TArray<FString> terms;
+	postings.GetKeys(terms);
+	terms.Sort([](const FString& A, const FString& B) { return A.Compare(B, ESearchCase::CaseSensitive) < 0; });
+
+	FCaptionSearchIndex index;
+	index.m_TermOffsets.Reserve(terms.Num() + 1);
+	index.m_PostingOffsets.Reserve(terms.Num() + 1);
+	for (const FString& term : terms)
+	{
+		index.m_TermOffsets.Add(index.m_TermChars.Num());
+		index.m_TermChars.Append(*term, term.Len());
+		index.m_PostingOffsets.Add(index.m_Postings.Num());
+		index.m_Postings.Append(postings[term]);
+	}
+	index.m_TermOffsets.Add(index.m_TermChars.Num());
+	index.m_PostingOffsets.Add(index.m_Postings.Num());
+
+	index.m_Documents.Reserve(Documents.Num());
+	for (const FCaptionSearchDocument& document : Documents)
+	{
+		index.m_Documents.Add(document.m_Hit);
+	}
+	return index;
+}
+
+//Returns the narrations matching every word of the query, in the order
+//the documents were given. Called on the game thread.
+TArray<FCaptionSearchHit> FCaptionSearchIndex::Search(const FString& Query, int32 MaxHits) const
+{
+	TArray<FCaptionSearchHit> hits;
+	if (!m_QueryIterator.IsValid())
+	{
+		m_QueryIterator = FBreakIterator::CreateWordBreakIterator();
+	}
+	TArray<FString> tokens;
+	Tokenize(Query, *m_QueryIterator, tokens);
+	if (tokens.Num() == 0 || m_Documents.Num() == 0)
+	{
+		return hits;
+	}
+
+	TBitArray<> matches(true, m_Documents.Num());
+	TBitArray<> tokenMatches;
+	for (const FString& token : tokens)
+	{
+		tokenMatches.Init(false, m_Documents.Num());
+		for (int32 term = LowerBound(token); term < NumTerms() && GetTerm(term).StartsWith(token, ESearchCase::CaseSensitive); term++)
+		{
+			for (int32 i = m_PostingOffsets[term]; i < m_PostingOffsets[term + 1]; i++)
+			{
+				tokenMatches[m_Postings[i]] = true;
+			}
+		}
+		matches.CombineWithBitwiseAND(tokenMatches, EBitwiseOperatorFlags::MinSize);
+	}
+
+	for (TConstSetBitIterator<> it(matches); it && hits.Num() < MaxHits; ++it)
+	{
+		hits.Add(m_Documents[it.GetIndex()]);
+	}
+	return hits;
+}
+
+SIZE_T FCaptionSearchIndex::GetAllocatedSize() const
+{
+	return m_TermChars.GetAllocatedSize() + m_TermOffsets.GetAllocatedSize() + m_PostingOffsets.GetAllocatedSize()
+		+ m_Postings.GetAllocatedSize() + m_Documents.GetAllocatedSize();
+}
+
+FStringView FCaptionSearchIndex::GetTerm(int32 Term) const
+{
+	return FStringView(m_TermChars.GetData() + m_TermOffsets[Term], m_TermOffsets[Term + 1] - m_TermOffsets[Term]);
+}
+
+//Returns the first term not sorted before the prefix.
+int32 FCaptionSearchIndex::LowerBound(FStringView Prefix) const
+{
+	int32 first = 0;
+	int32 count = NumTerms();
+	while (count > 0)
+	{
+		const int32 step = count / 2;
+		if (GetTerm(first + step).Compare(Prefix, ESearchCase::CaseSensitive) < 0)
+		{
+			first += step + 1;
+			count -= step + 1;
+		}
+		else
+		{
+			count = step;
+		}
+	}
+	return first;
+}
+
+static FAutoConsoleCommandWithArgsAndOutputDevice GameDataSearchCaptionsCommand(
+	TEXT("GameData.SearchCaptions"),
+	TEXT("Searches the caption texts of the loaded checkpoints and learn more panels, and reports the hits and the query time."),
+	FConsoleCommandWithArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, FOutputDevice& Ar)
+	{
+		const FString query = FString::Join(Args, TEXT(" "));
+		for (TObjectIterator<UGameData> it(RF_ClassDefaultObject); it; ++it)
+		{
+			const double start = FPlatformTime::Seconds();
+			const TArray<FCaptionSearchHit> hits = it->SearchCaptions(query, 20);
+			const double elapsed = FPlatformTime::Seconds() - start;
+
+			Ar.Logf(TEXT("%s: %d hits for \"%s\" in %.3f ms"), *it->GetName(), hits.Num(), *query, elapsed * 1000.0);
+			for (const FCaptionSearchHit& hit : hits)
+			{
+				if (hit.m_Source == ECaptionSearchSource::Checkpoint)
+				{
+					Ar.Logf(TEXT("    Checkpoint %d"), hit.m_CheckpointIndex);
+				}
+				else
+				{
+					Ar.Logf(TEXT("    Learn more %d (checkpoint %d)"), hit.m_LearnMoreIndex, hit.m_CheckpointIndex);
+				}
+			}
+		}
+	}));
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IBreakIterator;
+
+enum class ECaptionSearchSource : uint8
+{
+	Checkpoint,
+	LearnMore,
+};
+
+//Narration a search matched. Learn more hits also give the checkpoint
+//their panel belongs to.
+struct COLDWARPROJECT_API FCaptionSearchHit
+{
+	ECaptionSearchSource m_Source = ECaptionSearchSource::Checkpoint;
+	int32 m_CheckpointIndex = INDEX_NONE;
+	int32 m_LearnMoreIndex = INDEX_NONE;
+};
+
+//Caption texts (title and captions) of a narration, indexed as one document.
+struct COLDWARPROJECT_API FCaptionSearchDocument
+{
+	FCaptionSearchHit m_Hit;
+	TArray<FString> m_Texts;
+};
+
+//Inverted index of the caption texts for the visitor search. Terms are
+//the words of the captions, lowercased for the active culture and without
+//accents, stored sorted in a single character pool with the documents of
+//each term next to each other. Every word of a query matches the terms it
+//prefixes, so results are available while the visitor types.
+class COLDWARPROJECT_API FCaptionSearchIndex
+{
+public:
+	static FCaptionSearchIndex Build(const TArray<FCaptionSearchDocument>& Documents);
+	static void Tokenize(const FString& Text, IBreakIterator& WordIterator, TArray<FString>& OutTokens);
+
+	TArray<FCaptionSearchHit> Search(const FString& Query, int32 MaxHits) const;
+	int32 NumTerms() const { return m_TermOffsets.Num() > 0 ? m_TermOffsets.Num() - 1 : 0; }
+	int32 NumDocuments() const { return m_Documents.Num(); }
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	FStringView GetTerm(int32 Term) const;
+	int32 LowerBound(FStringView Prefix) const;
+
+	TArray<TCHAR> m_TermChars;
+	TArray<int32> m_TermOffsets;
+	TArray<int32> m_PostingOffsets;
+	TArray<int32> m_Postings;
+	TArray<FCaptionSearchHit> m_Documents;
+	mutable TSharedPtr<IBreakIterator> m_QueryIterator;
+};
@@ -0,0 +1,331 @@
+#include "CaptionTextTable.h"
+#include "Hash/CityHash.h"
+#include "Internationalization/Culture.h"
+#include "Internationalization/Internationalization.h"
+#include "Internationalization/StringTableRegistry.h"
+
+/*************************************
+Class: FCaptionTextTable
+Author: Antoine Plouffe
+
+Description: Table of the caption texts of the loaded content, resolved
+once for the active culture. Loaders register the caption keys found in
+the JSON files and hand ids to the UI. When the culture changes, the whole
+table is resolved again on a worker thread and swapped on the game thread.
+A shared table reads its keys and texts from an FSharedContentSegment and
+only copies the texts the UI displays. Registering a key the region does not hold, or
+switching culture, copies the table back before changing it.
+*************************************/
+
+//Returns the id of the given caption key, adding it to the table if
+//it was never registered. New keys are resolved on the next Resolve.
+//Every registration counts, and is undone by a ReleaseKey.
+int32 FCaptionTextTable::RegisterKey(const FString& Key)
+{
+	if (m_Shared)
+	{
+		const int32 sharedId = m_Shared->FindId(Key);
+		if (sharedId != INDEX_NONE)
+		{
+			m_RefCounts[sharedId]++;
+			return sharedId;
+		}
+		Unshare();
+	}
+	if (const int32* id = m_KeyToId.Find(Key))
+	{
+		m_RefCounts[*id]++;
+		return *id;
+	}
+
+	int32 id;
+	if (m_FreeIds.Num() > 0)
+	{
+		id = m_FreeIds.Pop(false);
+		m_Keys[id] = Key;
+		m_PendingIds.Add(id);
+		if (m_AppliedGeneration != m_Generation)
+		{
+			m_RebuildReusedIds.Add(id);
+		}
+	}
+	else
+	{
+		id = m_Keys.Add(Key);
+		m_RefCounts.Add(0);
+	}
+	m_KeyToId.Add(Key, id);
+	m_RefCounts[id] = 1;
+	return id;
+}
+
+//Undoes a registration of a caption id. Once no registration is left,
+//the key and its text are freed and the id is given to the next new key.
+//A shared table keeps its texts in the region, and only frees the ids
+//released meanwhile once it is copied back.
+void FCaptionTextTable::ReleaseKey(int32 Id)
+{
+	if (!m_RefCounts.IsValidIndex(Id) || m_RefCounts[Id] == 0 || --m_RefCounts[Id] > 0 || m_Shared)
+	{
+		return;
+	}
+	m_KeyToId.Remove(m_Keys[Id]);
+	m_Keys[Id].Empty();
+	if (m_Texts.IsValidIndex(Id))
+	{
+		m_Texts[Id] = FText::GetEmpty();
+	}
+	m_PendingIds.Remove(Id);
+	m_FreeIds.Add(Id);
+}
+
+//Returns the id of an already registered caption key, or INDEX_NONE.
+int32 FCaptionTextTable::FindId(const FString& Key) const
+{
+	if (m_Shared)
+	{
+		return m_Shared->FindId(Key);
+	}
+	const int32* id = m_KeyToId.Find(Key);
+	return id ? *id : INDEX_NONE;
+}
+
+//Resolves the keys registered since the last call. Called by the
+//loaders once they are done, so only new captions cost a lookup.
+void FCaptionTextTable::Resolve()
+{
+	if (m_Shared)
+	{
+		return;
+	}
+
+	for (int32 id : m_PendingIds)
+	{
+		if (m_Texts.IsValidIndex(id))
+		{
+			m_Texts[id] = ResolveKey(m_StringTableId, m_Keys[id]);
+		}
+	}
+	m_PendingIds.Reset();
+	m_Texts.Reserve(m_Keys.Num());
+	for (int i = m_Texts.Num(); i < m_Keys.Num(); i++)
+	{
+		m_Texts.Add(ResolveKey(m_StringTableId, m_Keys[i]));
+	}
+
+	if (m_IsShareRequested)
+	{
+		Share();
+	}
+}
+
+//Returns the text of a caption id, or an empty text for invalid ids.
+//A shared text is copied out of the region the first time it is shown,
+//and that copy is returned afterwards.
+const FText& FCaptionTextTable::GetText(int32 Id) const
+{
+	if (m_Shared)
+	{
+		const FStringView text = m_Shared->GetText(Id);
+		if (text.Len() == 0 || !m_SharedTexts.IsValidIndex(Id))
+		{
+			return FText::GetEmpty();
+		}
+		if (m_SharedTexts[Id].IsEmpty())
+		{
+			m_SharedTexts[Id] = FText::AsCultureInvariant(FString(text));
+		}
+		return m_SharedTexts[Id];
+	}
+	return m_Texts.IsValidIndex(Id) ? m_Texts[Id] : FText::GetEmpty();
+}
+
+//Returns the string of a caption id without copying it, or an empty view
+//for invalid ids. Shared strings are read from the region.
+FStringView FCaptionTextTable::GetString(int32 Id) const
+{
+	if (m_Shared)
+	{
+		return m_Shared->GetText(Id);
+	}
+	return m_Texts.IsValidIndex(Id) ? FStringView(m_Texts[Id].ToString()) : FStringView();
+}
+
+//Returns the memory used by the keys and the resolved texts.
+SIZE_T FCaptionTextTable::GetAllocatedSize() const
+{
+	SIZE_T size = m_Keys.GetAllocatedSize() + m_KeyToId.GetAllocatedSize() + m_Texts.GetAllocatedSize() + m_SharedTexts.GetAllocatedSize()
+		+ m_RefCounts.GetAllocatedSize() + m_FreeIds.GetAllocatedSize() + m_PendingIds.GetAllocatedSize();
+	for (const FString& key : m_Keys)
+	{
+		//Each key is stored in the array and in the id map.
+		size += key.GetAllocatedSize() * 2;
+	}
+	for (const FText& text : m_Texts)
+	{
+		size += text.ToString().GetAllocatedSize();
+	}
+	for (const FText& text : m_SharedTexts)
+	{
+		size += text.ToString().GetAllocatedSize();
+	}
+	return size;
+}
+
+//Starts a rebuild of the table. It invalidates any rebuild still running
+//and returns a copy of the keys to resolve on the worker thread.
+int32 FCaptionTextTable::BeginRebuild(TArray<FString>& OutKeys, FName& OutStringTableId)
+{
+	if (m_Shared)
+	{
+		OutKeys.Reset(m_Shared->Num());
+		for (int i = 0; i < m_Shared->Num(); i++)
+		{
+			OutKeys.Add(FString(m_Shared->GetKey(i)));
+		}
+	}
+	else
+	{
+		OutKeys = m_Keys;
+	}
+	OutStringTableId = m_StringTableId;
+	m_RebuildReusedIds.Reset();
+	return ++m_Generation;
+}
+
+//Resolves a list of keys. Safe to call from a worker thread, since the
+//string tables are only looked up and never loaded from here.
+TArray<FText> FCaptionTextTable::ResolveKeys(FName StringTableId, const TArray<FString>& Keys)
+{
+	TArray<FText> texts;
+	texts.Reserve(Keys.Num());
+	for (const FString& key : Keys)
+	{
+		texts.Add(ResolveKey(StringTableId, key));
+	}
+	return texts;
+}
+
+//Swaps in the texts of a rebuild, unless a newer rebuild was started.
+//Keys registered while the rebuild was running are resolved right away,
+//including the ones given an id released since, and released ids stay empty.
+void FCaptionTextTable::ApplyRebuild(int32 Generation, TArray<FText>&& Texts)
+{
+	if (Generation != m_Generation)
+	{
+		return;
+	}
+	Unshare();
+	m_Texts = MoveTemp(Texts);
+	for (int32 id : m_FreeIds)
+	{
+		if (m_Texts.IsValidIndex(id))
+		{
+			m_Texts[id] = FText::GetEmpty();
+		}
+	}
+	m_PendingIds.Append(m_RebuildReusedIds);
+	m_RebuildReusedIds.Reset();
+	m_AppliedGeneration = Generation;
+	Resolve();
+}
+
+//Resolves a caption key for the active culture. When the key is not in the
+//string table, the key itself is displayed so the issue is easy to spot.
+FText FCaptionTextTable::ResolveKey(FName StringTableId, const FString& Key)
+{
+	FStringTableConstPtr stringTable = FStringTableRegistry::Get().FindStringTable(StringTableId);
+	if (!stringTable.IsValid() || !stringTable->FindEntry(FTextKey(Key)).IsValid())
+	{
+		return FText::AsCultureInvariant(Key);
+	}
+	return FText::AsCultureInvariant(FText::FromStringTable(StringTableId, Key, EStringTableLoadingPolicy::Find).ToString());
+}
+
+//Maps the shared region of this table, publishing it if no other process
+//did, and drops the private keys and texts. The table is shared again
+//every time it is resolved from now on. Returns false when the table
+//could not be shared, in which case it keeps working from its own copy.
+//A region that could not be used is not tried again, since opening it
+//waits for the publisher on the game thread.
+bool FCaptionTextTable::Share()
+{
+	m_IsShareRequested = true;
+	if (m_Shared)
+	{
+		return true;
+	}
+	//Not shared while a culture switch is running, since the texts are
+	//about to change, or while some keys are not resolved yet.
+	if (m_Keys.Num() == 0 || m_Texts.Num() != m_Keys.Num() || m_AppliedGeneration != m_Generation)
+	{
+		return false;
+	}
+
+	const FString segmentName = MakeSegmentName();
+	if (m_FailedSegments.Contains(segmentName))
+	{
+		return false;
+	}
+	m_Shared = FSharedContentSegment::Open(segmentName, m_Keys, m_Texts);
+	if (!m_Shared)
+	{
+		m_FailedSegments.Add(segmentName);
+		return false;
+	}
+	m_SharedTexts.SetNum(m_Shared->Num());
+	m_Keys.Empty();
+	m_KeyToId.Empty();
+	m_Texts.Empty();
+	m_FreeIds.Empty();
+	return true;
+}
+
+//Names the region after the culture, the string table, the keys and
+//the texts, so only processes with the same table map the same region.
+FString FCaptionTextTable::MakeSegmentName() const
+{
+	const auto hashString = [](const FString& String, uint64 Seed)
+	{
+		return CityHash64WithSeed((const char*)*String, String.Len() * sizeof(TCHAR), Seed);
+	};
+
+	uint64 hash = hashString(FInternationalization::Get().GetCurrentCulture()->GetName(), 0);
+	hash = hashString(m_StringTableId.ToString(), hash);
+	for (int i = 0; i < m_Keys.Num(); i++)
+	{
+		hash = hashString(m_Keys[i], hash);
+		hash = hashString(m_Texts[i].ToString(), hash);
+	}
+	return FString::Printf(TEXT("GameDataCaptions_%u_%016llx"), FSharedContentSegment::Version, hash);
+}
+
+//Copies the keys and texts out of the shared region and unmaps it. The
+//ids released while shared are freed now.
+void FCaptionTextTable::Unshare()
+{
+	if (!m_Shared)
+	{
+		return;
+	}
+
+	const int32 num = m_Shared->Num();
+	m_Keys.Reserve(num);
+	m_KeyToId.Reserve(num);
+	m_Texts.Reserve(num);
+	for (int i = 0; i < num; i++)
+	{
+		if (m_RefCounts[i] == 0)
+		{
+			m_Keys.AddDefaulted();
+			m_Texts.AddDefaulted();
+			m_FreeIds.Add(i);
+			continue;
+		}
+		const int32 id = m_Keys.Add(FString(m_Shared->GetKey(i)));
+		m_KeyToId.Add(m_Keys[id], id);
+		m_Texts.Add(m_SharedTexts.IsValidIndex(i) && !m_SharedTexts[i].IsEmpty() ? m_SharedTexts[i] : FText::AsCultureInvariant(FString(m_Shared->GetText(i))));
+	}
+	m_Shared.Reset();
+	m_SharedTexts.Empty();
+}
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SharedContentSegment.h"
+
+//Caption ids of a narration, indexing the FCaptionTextTable.
+struct COLDWARPROJECT_API FNarrationCaptionIds
+{
+	int32 m_TitleId = INDEX_NONE;
+	TArray<int32> m_KeyIds;
+
+	SIZE_T GetAllocatedSize() const { return m_KeyIds.GetAllocatedSize(); }
+};
+
+//Compact table of the caption texts resolved for the active culture.
+//Every caption key gets an id when it is registered by a loader, and the
+//UI only deals with ids, so displaying a caption is an array index.
+//Ids are counted: content that goes away (a streamed out sublevel)
+//releases its ids, and the slots nothing uses anymore are reused.
+//Once shared, the keys and texts live in a shared memory region mapped by
+//every game process that loaded the same content.
+class COLDWARPROJECT_API FCaptionTextTable
+{
+public:
+	void SetStringTableId(FName StringTableId) { m_StringTableId = StringTableId; }
+	int32 RegisterKey(const FString& Key);
+	void ReleaseKey(int32 Id);
+	int32 FindId(const FString& Key) const;
+	void Resolve();
+	const FText& GetText(int32 Id) const;
+	FStringView GetString(int32 Id) const;
+	int32 Num() const { return m_Shared ? m_Shared->Num() : m_Keys.Num(); }
+	SIZE_T GetAllocatedSize() const;
+
+	//Multi-process installations: the table is shared whenever it is
+	//resolved, until a key that is not in the region is registered.
+	bool Share();
+	bool IsShared() const { return m_Shared.IsValid(); }
+	const FSharedContentSegment* GetSharedSegment() const { return m_Shared.Get(); }
+
+	//Culture switch: the keys are resolved on a worker thread and
+	//the result is applied on the game thread if still current.
+	int32 BeginRebuild(TArray<FString>& OutKeys, FName& OutStringTableId);
+	static TArray<FText> ResolveKeys(FName StringTableId, const TArray<FString>& Keys);
+	void ApplyRebuild(int32 Generation, TArray<FText>&& Texts);
+
+private:
+	static FText ResolveKey(FName StringTableId, const FString& Key);
+	FString MakeSegmentName() const;
+	void Unshare();
+
+	FName m_StringTableId;
+	TArray<FString> m_Keys;
+	TMap<FString, int32> m_KeyToId;
+	TArray<FText> m_Texts;
+	TArray<int32> m_RefCounts;
+	TArray<int32> m_FreeIds;
+	TArray<int32> m_PendingIds;
+	TArray<int32> m_RebuildReusedIds;
+	int32 m_Generation = 0;
+	int32 m_AppliedGeneration = 0;
+	TSharedPtr<FSharedContentSegment> m_Shared;
+	mutable TArray<FText> m_SharedTexts;
+	TSet<FString> m_FailedSegments;
+	bool m_IsShareRequested = false;
+};
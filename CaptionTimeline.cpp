@@ -0,0 +1,106 @@
+#include "CaptionTimeline.h"
+#include "Algo/BinarySearch.h"
+
+/*************************************
+Struct: FCaptionTimeline
+Author: Antoine Plouffe
+
+Description: Precomputed caption timing of a narration. Start times come
+from the JSON file when they are provided, otherwise they are derived from
+the duration of the narration sounds. The FCaptionTimelineCursor is then
+used by the UI to know which caption to display without searching.
+*************************************/
+
+//Builds the timeline of a narration. When the JSON provides one start time
+//per caption, they are used as is. When there is one sound per caption,
+//each caption starts at the end of the previous sound. Otherwise the
+//captions are spread evenly over the total duration of the sounds.
+FCaptionTimeline FCaptionTimeline::Build(const TArray<float>& StartTimes, const TArray<USoundBase*>& Sounds, int32 NumCaptions)
+{
+	FCaptionTimeline timeline;
+	timeline.m_StartTimes.Reserve(NumCaptions);
+
+	TArray<float> soundDurations;
+	for (USoundBase* sound : Sounds)
+	{
+		const float duration = sound ? sound->GetDuration() : 0.0f;
+		soundDurations.Add(duration);
+		timeline.m_Duration += duration;
+	}
+
+	if (StartTimes.Num() == NumCaptions)
+	{
+		float previousTime = 0.0f;
+		for (float startTime : StartTimes)
+		{
+			previousTime = FMath::Max(previousTime, startTime);
+			timeline.m_StartTimes.Add(previousTime);
+		}
+		timeline.m_Duration = FMath::Max(timeline.m_Duration, previousTime);
+	}
+	else if (soundDurations.Num() == NumCaptions)
+	{
+		float startTime = 0.0f;
+		for (float duration : soundDurations)
+		{
+			timeline.m_StartTimes.Add(startTime);
+			startTime += duration;
+		}
+	}
+	else
+	{
+		const float step = NumCaptions > 0 ? timeline.m_Duration / NumCaptions : 0.0f;
+		for (int i = 0; i < NumCaptions; i++)
+		{
+			timeline.m_StartTimes.Add(step * i);
+		}
+	}
+
+	return timeline;
+}
+
+//Returns the index of the caption displayed at the given playback time,
+//or INDEX_NONE before the first caption. Only used when the cursor seeks.
+int32 FCaptionTimeline::FindCaptionIndex(float PlaybackTime) const
+{
+	return Algo::UpperBound(m_StartTimes, PlaybackTime) - 1;
+}
+
+//Rewinds the cursor, for a narration that starts over.
+void FCaptionTimelineCursor::Reset()
+{
+	m_LastTimeline = nullptr;
+	m_CaptionIndex = INDEX_NONE;
+	m_LastTime = 0.0f;
+}
+
+//Moves the cursor to the given playback time of the timeline just looked
+//up and returns the caption to display. Playback normally only goes forward,
+//so the cursor steps from the current caption; a backward seek, or a
+//timeline other than the last one, falls back to a binary search. A null
+//timeline, whose narration was unloaded, rewinds the cursor.
+int32 FCaptionTimelineCursor::Advance(const FCaptionTimeline* Timeline, float PlaybackTime)
+{
+	if (!Timeline)
+	{
+		Reset();
+		return INDEX_NONE;
+	}
+
+	if (Timeline != m_LastTimeline || PlaybackTime < m_LastTime || m_CaptionIndex >= Timeline->Num())
+	{
+		m_LastTimeline = Timeline;
+		m_CaptionIndex = Timeline->FindCaptionIndex(PlaybackTime);
+	}
+	else
+	{
+		const TArray<float>& startTimes = Timeline->m_StartTimes;
+		while (m_CaptionIndex + 1 < startTimes.Num() && startTimes[m_CaptionIndex + 1] <= PlaybackTime)
+		{
+			m_CaptionIndex++;
+		}
+	}
+
+	m_LastTime = PlaybackTime;
+	return m_CaptionIndex;
+}
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Sound/SoundBase.h"
+#include "CaptionTimeline.generated.h"
+
+//Optional caption timing of a single narration entry. It is read from the
+//same JSON file as the narration data, so entries line up by index.
+USTRUCT()
+struct FCaptionTimingEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<float> EnglishCaptionStartTimes;
+	UPROPERTY()
+		TArray<float> FrenchCaptionStartTimes;
+};
+
+USTRUCT()
+struct FCaptionTimingData
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<FCaptionTimingEntry> Data;
+};
+
+//Start time (in seconds) of every caption of a narration, sorted.
+struct COLDWARPROJECT_API FCaptionTimeline
+{
+	TArray<float> m_StartTimes;
+	float m_Duration = 0.0f;
+
+	static FCaptionTimeline Build(const TArray<float>& StartTimes, const TArray<USoundBase*>& Sounds, int32 NumCaptions);
+	int32 FindCaptionIndex(float PlaybackTime) const;
+	int32 Num() const { return m_StartTimes.Num(); }
+	SIZE_T GetAllocatedSize() const { return m_StartTimes.GetAllocatedSize(); }
+};
+
+//Timelines of a narration for both languages, since the English and
+//French recordings do not have the same length.
+struct COLDWARPROJECT_API FNarrationCaptionTimelines
+{
+	FCaptionTimeline m_English;
+	FCaptionTimeline m_French;
+
+	SIZE_T GetAllocatedSize() const { return m_English.GetAllocatedSize() + m_French.GetAllocatedSize(); }
+};
+
+//Playback cursor owned by the UI. Advance is called every tick with the
+//current playback position and only walks forward from the last caption,
+//so the cost is O(1) amortized over a narration. The cursor does not keep
+//the timeline: UGameData replaces timelines when a tour is swapped or a
+//sublevel streams out, so the UI looks the timeline up again (for instance
+//with GetCheckpointCaptionTimelines) and passes it on every Advance.
+struct COLDWARPROJECT_API FCaptionTimelineCursor
+{
+	void Reset();
+	int32 Advance(const FCaptionTimeline* Timeline, float PlaybackTime);
+	int32 GetCaptionIndex() const { return m_CaptionIndex; }
+
+private:
+	//Only compared, to rewind when another timeline is passed. Never read.
+	const void* m_LastTimeline = nullptr;
+	int32 m_CaptionIndex = INDEX_NONE;
+	float m_LastTime = 0.0f;
+};
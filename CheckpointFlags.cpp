@@ -0,0 +1,70 @@
+#include "CheckpointFlags.h"
+
+/*************************************
+Class: FCheckpointFlags
+Author: Antoine Plouffe
+
+Description: Bitsets of the checkpoint flags read by LoadCheckpointsData
+(ShouldStopCamera, HasLearnMoreOption, HasQuiz), indexed like ActorsToFollow.
+Counting and searching use the set bit scans of TBitArray.
+*************************************/
+
+//Clears every flag and sizes the bitsets for the given number of checkpoints.
+void FCheckpointFlags::Reset(int32 NumCheckpoints)
+{
+	m_NumCheckpoints = NumCheckpoints;
+	for (TBitArray<>& bits : m_Bits)
+	{
+		bits.Init(false, NumCheckpoints);
+	}
+}
+
+void FCheckpointFlags::Set(int32 CheckpointIndex, ECheckpointFlag Flag, bool bValue)
+{
+	if (CheckpointIndex >= 0 && CheckpointIndex < m_NumCheckpoints)
+	{
+		m_Bits[(int32)Flag][CheckpointIndex] = bValue;
+	}
+}
+
+bool FCheckpointFlags::Has(int32 CheckpointIndex, ECheckpointFlag Flag) const
+{
+	return CheckpointIndex >= 0 && CheckpointIndex < m_NumCheckpoints && m_Bits[(int32)Flag][CheckpointIndex];
+}
+
+SIZE_T FCheckpointFlags::GetAllocatedSize() const
+{
+	SIZE_T size = 0;
+	for (const TBitArray<>& bits : m_Bits)
+	{
+		size += bits.GetAllocatedSize();
+	}
+	return size;
+}
+
+//Returns the number of checkpoints with the flag in the whole tour.
+int32 FCheckpointFlags::Count(ECheckpointFlag Flag) const
+{
+	return m_Bits[(int32)Flag].CountSetBits();
+}
+
+//Returns the number of checkpoints with the flag from
+//the given checkpoint (included) to the end of the tour.
+int32 FCheckpointFlags::CountRemaining(ECheckpointFlag Flag, int32 FromCheckpointIndex) const
+{
+	const int32 from = FMath::Clamp(FromCheckpointIndex, 0, m_NumCheckpoints);
+	return m_Bits[(int32)Flag].CountSetBits(from, m_NumCheckpoints);
+}
+
+//Returns the index of the first checkpoint with the flag after the
+//given checkpoint, or INDEX_NONE. Pass INDEX_NONE to search from the start.
+int32 FCheckpointFlags::FindNext(ECheckpointFlag Flag, int32 FromCheckpointIndex) const
+{
+	const int32 start = FMath::Max(FromCheckpointIndex + 1, 0);
+	if (start >= m_NumCheckpoints)
+	{
+		return INDEX_NONE;
+	}
+	TConstSetBitIterator<> it(m_Bits[(int32)Flag], start);
+	return it ? it.GetIndex() : INDEX_NONE;
+}
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class ECheckpointFlag : uint8
+{
+	ShouldStopCamera,
+	HasLearnMoreOption,
+	HasQuiz,
+	Num
+};
+
+//One bitset per checkpoint flag over the checkpoint indices (the order of
+//ActorsToFollow). Feature queries such as "next checkpoint with a quiz" or
+//"learn more stops remaining" are word-wide bit scans instead of map walks.
+class COLDWARPROJECT_API FCheckpointFlags
+{
+public:
+	void Reset(int32 NumCheckpoints);
+	void Set(int32 CheckpointIndex, ECheckpointFlag Flag, bool bValue);
+
+	bool Has(int32 CheckpointIndex, ECheckpointFlag Flag) const;
+	int32 Count(ECheckpointFlag Flag) const;
+	int32 CountRemaining(ECheckpointFlag Flag, int32 FromCheckpointIndex) const;
+	int32 FindNext(ECheckpointFlag Flag, int32 FromCheckpointIndex) const;
+	int32 NumCheckpoints() const { return m_NumCheckpoints; }
+	const TBitArray<>& GetBits(ECheckpointFlag Flag) const { return m_Bits[(int32)Flag]; }
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	TBitArray<> m_Bits[(int32)ECheckpointFlag::Num];
+	int32 m_NumCheckpoints = 0;
+};
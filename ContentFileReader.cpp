@@ -0,0 +1,448 @@
+#include "ContentFileReader.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include <atomic>
+
+#if PLATFORM_LINUX && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define GAMEDATA_WITH_IO_URING 1
+#endif
+#endif
+#endif
+
+#ifndef GAMEDATA_WITH_IO_URING
+#define GAMEDATA_WITH_IO_URING 0
+#endif
+
+/*************************************
+Class: FContentFileReader
+Author: Antoine Plouffe
+
+Description: Batched reads of the content files. On Linux, a batch is read
+through an io_uring ring whose buffers are registered once, so the reads of
+every file of the batch are in flight together and the kernel does not pin
+and unpin pages for each of them. Rings are pooled and reused by the worker
+threads. The toolchain headers, the kernel or a seccomp profile may not
+allow io_uring; the first failure disables it for the session.
+*************************************/
+
+static TAutoConsoleVariable<bool> CVarGameDataIoUringReads(
+	TEXT("GameData.IoUringReads"),
+	false,
+	TEXT("Reads batches of content files through io_uring on Linux. Falls back to the platform file layer when io_uring is not available."));
+
+#if GAMEDATA_WITH_IO_URING
+namespace
+{
+	//Ring of NumBuffers reads of at most BufferSize bytes, each read
+	//going in the registered buffer of its slot.
+	class FContentIoRing
+	{
+	public:
+		static constexpr uint32 NumBuffers = 16;
+		static constexpr uint32 BufferSize = 64 * 1024;
+
+		~FContentIoRing();
+		bool Init();
+		bool Read(const TArray<FString>& Paths, TArray<TArray<uint8>>& OutContents, TBitArray<>& OutSucceeded);
+
+	private:
+		struct FFileRead
+		{
+			int m_Fd = -1;
+			int64 m_Size = 0;
+			int64 m_NextOffset = 0;
+			int32 m_NumPending = 0;
+			bool m_Failed = false;
+		};
+
+		struct FSlot
+		{
+			int32 m_File = INDEX_NONE;
+			int64 m_Offset = 0;
+			uint32 m_Length = 0;
+		};
+
+		void QueueRead(int32 Slot, int Fd, int64 Offset, uint32 Length);
+		uint8* GetBuffer(int32 Slot) const { return m_Buffers + (SIZE_T)Slot * BufferSize; }
+
+		int m_RingFd = -1;
+		void* m_SqRing = MAP_FAILED;
+		void* m_CqRing = MAP_FAILED;
+		void* m_Sqes = MAP_FAILED;
+		SIZE_T m_SqRingSize = 0;
+		SIZE_T m_CqRingSize = 0;
+		SIZE_T m_SqesSize = 0;
+		uint32* m_SqHead = nullptr;
+		uint32* m_SqTail = nullptr;
+		uint32* m_SqArray = nullptr;
+		uint32 m_SqMask = 0;
+		uint32* m_CqHead = nullptr;
+		uint32* m_CqTail = nullptr;
+		uint32 m_CqMask = 0;
+		io_uring_cqe* m_Cqes = nullptr;
+		uint8* m_Buffers = nullptr;
+	};
+
+	FCriticalSection GFreeRingsLock;
+	TArray<TUniquePtr<FContentIoRing>> GFreeRings;
+	std::atomic<bool> GIoUringFailed{ false };
+
+	TUniquePtr<FContentIoRing> AcquireRing()
+	{
+		{
+			FScopeLock lock(&GFreeRingsLock);
+			if (GFreeRings.Num() > 0)
+			{
+				return GFreeRings.Pop();
+			}
+		}
+		if (GIoUringFailed)
+		{
+			return nullptr;
+		}
+
+		TUniquePtr<FContentIoRing> ring = MakeUnique<FContentIoRing>();
+		if (!ring->Init())
+		{
+			GIoUringFailed = true;
+			return nullptr;
+		}
+		return ring;
+	}
+
+	void ReleaseRing(TUniquePtr<FContentIoRing>&& Ring)
+	{
+		FScopeLock lock(&GFreeRingsLock);
+		GFreeRings.Add(MoveTemp(Ring));
+	}
+
+	FContentIoRing::~FContentIoRing()
+	{
+		if (m_Sqes != MAP_FAILED) munmap(m_Sqes, m_SqesSize);
+		if (m_CqRing != MAP_FAILED) munmap(m_CqRing, m_CqRingSize);
+		if (m_SqRing != MAP_FAILED) munmap(m_SqRing, m_SqRingSize);
+		//Closing the ring also unregisters the buffers.
+		if (m_RingFd >= 0) close(m_RingFd);
+		if (m_Buffers) FMemory::Free(m_Buffers);
+	}
+
+	//Creates the ring, maps its queues and registers the read buffers.
+	bool FContentIoRing::Init()
+	{
+		io_uring_params params;
+		FMemory::Memzero(params);
+		m_RingFd = (int)syscall(__NR_io_uring_setup, NumBuffers, &params);
+		if (m_RingFd < 0)
+		{
+			return false;
+		}
+
+		m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32);
+		m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		m_SqRing = mmap(nullptr, m_SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_RingFd, IORING_OFF_SQ_RING);
+		m_CqRing = mmap(nullptr, m_CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_RingFd, IORING_OFF_CQ_RING);
+		m_Sqes = mmap(nullptr, m_SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_RingFd, IORING_OFF_SQES);
+		if (m_SqRing == MAP_FAILED || m_CqRing == MAP_FAILED || m_Sqes == MAP_FAILED)
+		{
+			return false;
+		}
+
+		uint8* sqRing = (uint8*)m_SqRing;
+		m_SqHead = (uint32*)(sqRing + params.sq_off.head);
+		m_SqTail = (uint32*)(sqRing + params.sq_off.tail);
+		m_SqArray = (uint32*)(sqRing + params.sq_off.array);
+		m_SqMask = *(uint32*)(sqRing + params.sq_off.ring_mask);
+		uint8* cqRing = (uint8*)m_CqRing;
+		m_CqHead = (uint32*)(cqRing + params.cq_off.head);
+		m_CqTail = (uint32*)(cqRing + params.cq_off.tail);
+		m_CqMask = *(uint32*)(cqRing + params.cq_off.ring_mask);
+		m_Cqes = (io_uring_cqe*)(cqRing + params.cq_off.cqes);
+
+		m_Buffers = (uint8*)FMemory::Malloc((SIZE_T)NumBuffers * BufferSize, 4096);
+		iovec buffers[NumBuffers];
+		for (uint32 i = 0; i < NumBuffers; i++)
+		{
+			buffers[i].iov_base = GetBuffer(i);
+			buffers[i].iov_len = BufferSize;
+		}
+		return syscall(__NR_io_uring_register, m_RingFd, IORING_REGISTER_BUFFERS, buffers, NumBuffers) == 0;
+	}
+
+	void FContentIoRing::QueueRead(int32 Slot, int Fd, int64 Offset, uint32 Length)
+	{
+		const uint32 tail = *m_SqTail;
+		const uint32 index = tail & m_SqMask;
+		io_uring_sqe& sqe = ((io_uring_sqe*)m_Sqes)[index];
+		FMemory::Memzero(sqe);
+		sqe.opcode = IORING_OP_READ_FIXED;
+		sqe.fd = Fd;
+		sqe.off = (uint64)Offset;
+		sqe.addr = (uint64)GetBuffer(Slot);
+		sqe.len = Length;
+		sqe.buf_index = (uint16)Slot;
+		sqe.user_data = (uint64)Slot;
+		m_SqArray[index] = index;
+		__atomic_store_n(m_SqTail, tail + 1, __ATOMIC_RELEASE);
+	}
+
+	//Reads every file in chunks of BufferSize, keeping all the buffers in
+	//flight. Files that cannot be opened are left for the platform file
+	//layer. Returns false when the ring itself failed and must be dropped.
+	bool FContentIoRing::Read(const TArray<FString>& Paths, TArray<TArray<uint8>>& OutContents, TBitArray<>& OutSucceeded)
+	{
+		TArray<FFileRead> files;
+		files.SetNum(Paths.Num());
+		for (int i = 0; i < Paths.Num(); i++)
+		{
+			const FString path = IFileManager::Get().ConvertToAbsolutePathForExternalAppForRead(*Paths[i]);
+			const int fd = open(TCHAR_TO_UTF8(*path), O_RDONLY | O_CLOEXEC);
+			struct stat status;
+			if (fd < 0)
+			{
+				continue;
+			}
+			if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode))
+			{
+				close(fd);
+				continue;
+			}
+
+			OutContents[i].SetNumUninitialized((int32)status.st_size);
+			if (status.st_size == 0)
+			{
+				close(fd);
+				OutSucceeded[i] = true;
+				continue;
+			}
+			files[i].m_Fd = fd;
+			files[i].m_Size = status.st_size;
+		}
+
+		FSlot slots[NumBuffers];
+		TArray<int32, TInlineAllocator<NumBuffers>> freeSlots;
+		for (int32 i = NumBuffers - 1; i >= 0; i--)
+		{
+			freeSlots.Add(i);
+		}
+
+		bool ringFailed = false;
+		int32 nextFile = 0;
+		int32 numInFlight = 0;
+		while (!ringFailed)
+		{
+			//Queue the next chunks in the free buffers.
+			while (freeSlots.Num() > 0)
+			{
+				while (nextFile < files.Num() && (files[nextFile].m_Fd < 0 || files[nextFile].m_Failed || files[nextFile].m_NextOffset >= files[nextFile].m_Size))
+				{
+					nextFile++;
+				}
+				if (nextFile == files.Num())
+				{
+					break;
+				}
+
+				FFileRead& file = files[nextFile];
+				FSlot& slot = slots[freeSlots.Last()];
+				slot.m_File = nextFile;
+				slot.m_Offset = file.m_NextOffset;
+				slot.m_Length = (uint32)FMath::Min<int64>(BufferSize, file.m_Size - file.m_NextOffset);
+				QueueRead(freeSlots.Pop(), file.m_Fd, slot.m_Offset, slot.m_Length);
+				file.m_NextOffset += slot.m_Length;
+				file.m_NumPending++;
+				numInFlight++;
+			}
+			if (numInFlight == 0)
+			{
+				break;
+			}
+
+			const uint32 numToSubmit = *m_SqTail - __atomic_load_n(m_SqHead, __ATOMIC_ACQUIRE);
+			if (syscall(__NR_io_uring_enter, m_RingFd, numToSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+			{
+				ringFailed = true;
+				break;
+			}
+
+			//Copy the completed chunks out of their buffers.
+			uint32 head = *m_CqHead;
+			const uint32 tail = __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE);
+			for (; head != tail; head++)
+			{
+				const io_uring_cqe& cqe = m_Cqes[head & m_CqMask];
+				const int32 slotIndex = (int32)cqe.user_data;
+				FSlot& slot = slots[slotIndex];
+				FFileRead& file = files[slot.m_File];
+				if (cqe.res <= 0)
+				{
+					//Error, or the file was truncated while being read.
+					file.m_Failed = true;
+				}
+				else
+				{
+					FMemory::Memcpy(OutContents[slot.m_File].GetData() + slot.m_Offset, GetBuffer(slotIndex), cqe.res);
+					if ((uint32)cqe.res < slot.m_Length)
+					{
+						//Short read, the rest is read again in the same buffer.
+						slot.m_Offset += cqe.res;
+						slot.m_Length -= cqe.res;
+						QueueRead(slotIndex, file.m_Fd, slot.m_Offset, slot.m_Length);
+						continue;
+					}
+				}
+
+				file.m_NumPending--;
+				numInFlight--;
+				freeSlots.Add(slotIndex);
+				if (file.m_NumPending == 0 && (file.m_Failed || file.m_NextOffset >= file.m_Size))
+				{
+					close(file.m_Fd);
+					file.m_Fd = -1;
+					OutSucceeded[slot.m_File] = !file.m_Failed;
+				}
+			}
+			__atomic_store_n(m_CqHead, head, __ATOMIC_RELEASE);
+		}
+
+		for (int i = 0; i < files.Num(); i++)
+		{
+			if (files[i].m_Fd >= 0)
+			{
+				close(files[i].m_Fd);
+			}
+			if (!OutSucceeded[i])
+			{
+				OutContents[i].Reset();
+			}
+		}
+		return !ringFailed;
+	}
+}
+#endif
+
+//Reads a single file through the platform file layer.
+bool FContentFileReader::ReadFile(const FString& Path, TArray<uint8>& OutContent)
+{
+	return FFileHelper::LoadFileToArray(OutContent, *Path, FILEREAD_Silent);
+}
+
+//Reads a batch of files, through io_uring when enabled. The files io_uring
+//could not read are read again through the platform file layer.
+void FContentFileReader::ReadFiles(const TArray<FString>& Paths, TArray<TArray<uint8>>& OutContents, TBitArray<>& OutSucceeded)
+{
+	if (!IsIoUringEnabled() || !ReadFilesWithIoUring(Paths, OutContents, OutSucceeded))
+	{
+		ReadFilesWithPlatformFile(Paths, OutContents, OutSucceeded);
+		return;
+	}
+
+	for (int i = 0; i < Paths.Num(); i++)
+	{
+		if (!OutSucceeded[i])
+		{
+			OutSucceeded[i] = ReadFile(Paths[i], OutContents[i]);
+		}
+	}
+}
+
+void FContentFileReader::ReadFilesWithPlatformFile(const TArray<FString>& Paths, TArray<TArray<uint8>>& OutContents, TBitArray<>& OutSucceeded)
+{
+	OutContents.SetNum(Paths.Num());
+	OutSucceeded.Init(false, Paths.Num());
+	for (int i = 0; i < Paths.Num(); i++)
+	{
+		OutSucceeded[i] = ReadFile(Paths[i], OutContents[i]);
+	}
+}
+
+//Reads a batch of files through io_uring, whatever GameData.IoUringReads
+//is. Returns false when io_uring is not available, in which case nothing
+//was read. Otherwise, OutSucceeded tells which files were read.
+bool FContentFileReader::ReadFilesWithIoUring(const TArray<FString>& Paths, TArray<TArray<uint8>>& OutContents, TBitArray<>& OutSucceeded)
+{
+#if GAMEDATA_WITH_IO_URING
+	TUniquePtr<FContentIoRing> ring = AcquireRing();
+	if (!ring)
+	{
+		return false;
+	}
+
+	OutContents.SetNum(Paths.Num());
+	OutSucceeded.Init(false, Paths.Num());
+	if (ring->Read(Paths, OutContents, OutSucceeded))
+	{
+		ReleaseRing(MoveTemp(ring));
+	}
+	else
+	{
+		//Reads may still be in flight in the buffers of the ring, so it is
+		//left alive, and io_uring is not used again this session.
+		GIoUringFailed = true;
+		ring.Release();
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool FContentFileReader::IsIoUringAvailable()
+{
+#if GAMEDATA_WITH_IO_URING
+	TUniquePtr<FContentIoRing> ring = AcquireRing();
+	if (!ring)
+	{
+		return false;
+	}
+	ReleaseRing(MoveTemp(ring));
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool FContentFileReader::IsIoUringEnabled()
+{
+	return CVarGameDataIoUringReads.GetValueOnAnyThread() && IsIoUringAvailable();
+}
+
+//Reads the given files at once. Duplicated paths are read once.
+FContentFileBatch::FContentFileBatch(const TArray<FString>& Paths)
+{
+	TArray<FString> uniquePaths;
+	for (const FString& path : Paths)
+	{
+		uniquePaths.AddUnique(path);
+	}
+
+	TArray<TArray<uint8>> contents;
+	TBitArray<> succeeded;
+	FContentFileReader::ReadFiles(uniquePaths, contents, succeeded);
+	for (int i = 0; i < uniquePaths.Num(); i++)
+	{
+		if (succeeded[i])
+		{
+			m_Contents.Add(uniquePaths[i], MoveTemp(contents[i]));
+		}
+	}
+}
+
+//Returns the content of a file of the batch, or nullptr when
+//it is not part of the batch or could not be read.
+const TArray<uint8>* FContentFileBatch::Find(const FString& Path) const
+{
+	return m_Contents.Find(Path);
+}
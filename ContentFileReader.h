@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Reads the raw content files of the tour. On Linux, batches of files are
+//read through io_uring with registered buffers when GameData.IoUringReads
+//is set and the kernel allows it. Everywhere else, and for the files the
+//ring cannot open (pak files, missing files), reads go through the
+//platform file layer.
+class COLDWARPROJECT_API FContentFileReader
+{
+public:
+	static bool ReadFile(const FString& Path, TArray<uint8>& OutContent);
+	static void ReadFiles(const TArray<FString>& Paths, TArray<TArray<uint8>>& OutContents, TBitArray<>& OutSucceeded);
+	static void ReadFilesWithPlatformFile(const TArray<FString>& Paths, TArray<TArray<uint8>>& OutContents, TBitArray<>& OutSucceeded);
+	static bool ReadFilesWithIoUring(const TArray<FString>& Paths, TArray<TArray<uint8>>& OutContents, TBitArray<>& OutSucceeded);
+
+	static bool IsIoUringAvailable();
+	static bool IsIoUringEnabled();
+};
+
+//Raw content of a set of files read in one batch, handed to the parse
+//cache so the structs read from the same file do not read it again.
+class COLDWARPROJECT_API FContentFileBatch
+{
+public:
+	FContentFileBatch() = default;
+	explicit FContentFileBatch(const TArray<FString>& Paths);
+
+	const TArray<uint8>* Find(const FString& Path) const;
+
+private:
+	TMap<FString, TArray<uint8>> m_Contents;
+};
@@ -0,0 +1,21 @@
+#include "ContentLoader.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogContentLoader, Log, All);
+
+/*************************************
+Class: TContentLoader
+Author: Antoine Plouffe
+
+Description: Shared path of the content loaders of UGameData: parse cache,
+latency histograms, LLM tag, memory report and problem reporting. Problems
+go to the log and to the screen, like the loaders always reported them.
+*************************************/
+
+void FContentDiagnostics::Report(const TCHAR* LoaderName, const FString& Path) const
+{
+	for (const FString& problem : m_Problems)
+	{
+		UE_LOG(LogContentLoader, Warning, TEXT("%s %s: %s"), LoaderName, *Path, *problem);
+		if (GEngine) GEngine->AddOnScreenDebugMessage(-1, 60.0f, FColor::Green, problem);
+	}
+}
@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "JsonHelper.h"
+#include "JsonParseCache.h"
+#include "GameDataLatency.h"
+#include "GameDataMemory.h"
+#include "GameDataPipeline.h"
+#include "UObject/StrongObjectPtr.h"
+
+//Problems found while loading a content file. They are reported together
+//once the file is loaded, each one once, instead of one on-screen message
+//per entry of the file.
+struct COLDWARPROJECT_API FContentDiagnostics
+{
+	TArray<FString> m_Problems;
+
+	void Add(const FString& Problem) { m_Problems.AddUnique(Problem); }
+	void Report(const TCHAR* LoaderName, const FString& Path) const;
+};
+
+//What the content loaders share with UGameData.
+struct FContentLoadEnvironment
+{
+	const FJsonParseCache* m_ParseCache = nullptr;
+	UJsonHelper* m_JsonHelper = nullptr;
+	const FVisitorSessionState* m_SessionState = nullptr;
+	TMap<FString, FGameDataMemoryReport>* m_ContentMemory = nullptr;
+};
+
+//Given to the transform of a content loader, to read the other structs of
+//the same file (caption timing, tour graph, ...) and to report problems.
+//The file is read once for the whole load, or before the load when a
+//worker already read it.
+class FContentLoadContext
+{
+public:
+	FContentLoadContext(const FContentLoadEnvironment& Environment, const FJsonContentFile& File, FContentDiagnostics& Diagnostics)
+		: m_Environment(Environment), m_File(File), m_Diagnostics(Diagnostics)
+	{
+	}
+
+	template<typename T>
+	T Read() const
+	{
+		bool success;
+		FString message;
+		T data = m_Environment.m_ParseCache->ReadStruct<T>(m_Environment.m_JsonHelper, m_File, success, message);
+		Check(success, message);
+		return data;
+	}
+
+	void Check(bool bSuccess, const FString& Message) const
+	{
+		if (!bSuccess)
+		{
+			m_Diagnostics.Add(Message);
+		}
+	}
+
+	const FString& GetPath() const { return m_File.GetPath(); }
+	bool HasProblems() const { return m_Diagnostics.m_Problems.Num() > 0; }
+
+private:
+	const FContentLoadEnvironment& m_Environment;
+	const FJsonContentFile& m_File;
+	FContentDiagnostics& m_Diagnostics;
+};
+
+//Measures the runtime content a loader returns, for the types the memory
+//report knows. Other types are not measured.
+template<typename T>
+void MeasureContent(FGameDataMemoryReport& Report, const T& Content) {}
+inline void MeasureContent(FGameDataMemoryReport& Report, const FInstructionGameData& Content) { Report.Measure(Content); }
+inline void MeasureContent(FGameDataMemoryReport& Report, const FCheckpointsGameData& Content) { Report.Measure(Content); }
+inline void MeasureContent(FGameDataMemoryReport& Report, const FLearnMoreGameData& Content) { Report.Measure(Content); }
+inline void MeasureContent(FGameDataMemoryReport& Report, const FTilesGameData& Content) { Report.Measure(Content); }
+
+//Loader of a content file read into TSource and turned into TRuntime. The
+//loader reads the file through the parse cache, times the load, tags its
+//allocations, measures the result and reports the problems; each content
+//type only supplies the transform from TSource to TRuntime. A file already
+//read on a worker thread is loaded without touching the disk again, and
+//LoadAsync does that read itself:
+//
+//	TRuntime Transform(const TSource& Source, const FContentLoadContext& Context);
+template<typename TSource, typename TRuntime>
+class TContentLoader
+{
+public:
+	explicit TContentLoader(const TCHAR* Name)
+		: m_Name(Name)
+	{
+	}
+
+	template<typename TTransform>
+	TRuntime Load(const FContentLoadEnvironment& Environment, const FString& Path, int32 CheckpointIndex, TTransform&& Transform) const;
+	template<typename TTransform>
+	TRuntime Load(const FContentLoadEnvironment& Environment, const FJsonContentFile& File, int32 CheckpointIndex, TTransform&& Transform) const;
+
+	template<typename TTransform>
+	TSharedRef<FGameDataPipeline> LoadAsync(UObject* Owner, const FContentLoadEnvironment& Environment, const FString& Path, int32 CheckpointIndex, TTransform&& Transform, TUniqueFunction<void(TRuntime&&)>&& OnLoaded) const;
+
+private:
+	template<typename TTransform>
+	TRuntime LoadFile(const FContentLoadEnvironment& Environment, const FJsonContentFile& File, TTransform&& Transform) const;
+
+	const TCHAR* m_Name;
+};
+
+template<typename TSource, typename TRuntime>
+template<typename TTransform>
+TRuntime TContentLoader<TSource, TRuntime>::Load(const FContentLoadEnvironment& Environment, const FString& Path, int32 CheckpointIndex, TTransform&& Transform) const
+{
+	FGameDataLatencyScope latencyScope(m_Name, *Environment.m_SessionState, CheckpointIndex);
+	const FJsonContentFile file(Path);
+	return LoadFile(Environment, file, Forward<TTransform>(Transform));
+}
+
+template<typename TSource, typename TRuntime>
+template<typename TTransform>
+TRuntime TContentLoader<TSource, TRuntime>::Load(const FContentLoadEnvironment& Environment, const FJsonContentFile& File, int32 CheckpointIndex, TTransform&& Transform) const
+{
+	FGameDataLatencyScope latencyScope(m_Name, *Environment.m_SessionState, CheckpointIndex);
+	return LoadFile(Environment, File, Forward<TTransform>(Transform));
+}
+
+template<typename TSource, typename TRuntime>
+template<typename TTransform>
+TRuntime TContentLoader<TSource, TRuntime>::LoadFile(const FContentLoadEnvironment& Environment, const FJsonContentFile& File, TTransform&& Transform) const
+{
+	LLM_SCOPE_BYTAG(GameData);
+
+	const FString& Path = File.GetPath();
+	FContentDiagnostics diagnostics;
+	const FContentLoadContext context(Environment, File, diagnostics);
+	const TSource source = context.Read<TSource>();
+	TRuntime runtime = Transform(source, context);
+	diagnostics.Report(m_Name, Path);
+
+	if (Environment.m_ContentMemory)
+	{
+		FGameDataMemoryReport& report = Environment.m_ContentMemory->FindOrAdd(Path);
+		report = FGameDataMemoryReport();
+		MeasureContent(report, runtime);
+	}
+	return runtime;
+}
+
+//Reads and prefetches the file on a worker thread, then transforms it on
+//the game thread from the file the worker read and calls OnLoaded. The
+//loader and the environment belong to the owner, which is kept alive
+//until the pipeline is done.
+template<typename TSource, typename TRuntime>
+template<typename TTransform>
+TSharedRef<FGameDataPipeline> TContentLoader<TSource, TRuntime>::LoadAsync(UObject* Owner, const FContentLoadEnvironment& Environment, const FString& Path, int32 CheckpointIndex, TTransform&& Transform, TUniqueFunction<void(TRuntime&&)>&& OnLoaded) const
+{
+	TSharedRef<FGameDataPipeline> pipeline = FGameDataPipeline::Create();
+	TSharedRef<TStrongObjectPtr<UObject>> keepAlive = MakeShared<TStrongObjectPtr<UObject>>(Owner);
+	TSharedRef<TOptional<FJsonContentFile>> file = MakeShared<TOptional<FJsonContentFile>>();
+	pipeline->OnWorker([Environment, Path, file]()
+	{
+		const FContentFileBatch batch({ Path });
+		file->Emplace(Path, &batch);
+		Environment.m_ParseCache->template Prefetch<TSource>(Environment.m_JsonHelper, file->GetValue());
+	})
+	.OnGameThread([this, Environment, file, CheckpointIndex, Transform = Forward<TTransform>(Transform), OnLoaded = MoveTemp(OnLoaded)]() mutable
+	{
+		OnLoaded(Load(Environment, file->GetValue(), CheckpointIndex, Transform));
+	})
+	.Start([keepAlive](bool bCompleted)
+	{
+		keepAlive->Reset();
+	});
+	return pipeline;
+}
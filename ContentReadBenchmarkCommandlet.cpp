@@ -0,0 +1,209 @@
+#include "ContentReadBenchmarkCommandlet.h"
+#include "ContentFileReader.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if PLATFORM_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+DEFINE_LOG_CATEGORY_STATIC(LogContentReadBenchmark, Log, All);
+
+/*************************************
+Class: UContentReadBenchmarkCommandlet
+Author: Antoine Plouffe
+
+Description: Benchmark of the content file reads, run on the kiosk hardware
+before enabling GameData.IoUringReads. The files are read in batches like
+the segment loading does, and each configuration reports the median and
+worst time of a full pass over the files.
+*************************************/
+
+namespace
+{
+	struct FReadTiming
+	{
+		double m_Median = 0.0;
+		double m_Worst = 0.0;
+	};
+
+	bool CreateBenchmarkFiles(const FString& Directory, int32 NumFiles, int32 FileSizeKB, TArray<FString>& OutPaths)
+	{
+		TArray<uint8> content;
+		content.SetNumUninitialized(FileSizeKB * 1024);
+		for (int i = 0; i < NumFiles; i++)
+		{
+			for (int32 j = 0; j < content.Num(); j++)
+			{
+				content[j] = (uint8)FMath::RandRange(32, 126);
+			}
+			const FString path = Directory / FString::Printf(TEXT("BenchmarkFile_%d.json"), i);
+			if (!FFileHelper::SaveArrayToFile(content, *path))
+			{
+				return false;
+			}
+			OutPaths.Add(path);
+		}
+		return true;
+	}
+
+	//Drops the files from the page cache, so the next read goes to the
+	//disk. Returns false where it is not supported.
+	bool EvictFromPageCache(const TArray<FString>& Paths)
+	{
+#if PLATFORM_LINUX
+		for (const FString& path : Paths)
+		{
+			const int fd = open(TCHAR_TO_UTF8(*IFileManager::Get().ConvertToAbsolutePathForExternalAppForRead(*path)), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+			{
+				return false;
+			}
+			posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+			close(fd);
+		}
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	template<typename TReadBatch>
+	FReadTiming TimeReads(const TArray<FString>& Paths, int32 BatchSize, int32 NumRuns, bool bCold, TReadBatch&& ReadBatch)
+	{
+		TArray<double> times;
+		for (int run = 0; run < NumRuns; run++)
+		{
+			if (bCold)
+			{
+				EvictFromPageCache(Paths);
+			}
+
+			const double start = FPlatformTime::Seconds();
+			for (int32 first = 0; first < Paths.Num(); first += BatchSize)
+			{
+				const TArray<FString> batch(Paths.GetData() + first, FMath::Min(BatchSize, Paths.Num() - first));
+				ReadBatch(batch);
+			}
+			times.Add(FPlatformTime::Seconds() - start);
+		}
+
+		times.Sort();
+		FReadTiming timing;
+		timing.m_Median = times[times.Num() / 2];
+		timing.m_Worst = times.Last();
+		return timing;
+	}
+}
+
+UContentReadBenchmarkCommandlet::UContentReadBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UContentReadBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString contentDir;
+	int32 numFiles = 200;
+	int32 fileSizeKB = 16;
+	int32 batchSize = 8;
+	int32 numRuns = 20;
+	FParse::Value(*Params, TEXT("Content="), contentDir);
+	FParse::Value(*Params, TEXT("Files="), numFiles);
+	FParse::Value(*Params, TEXT("FileSizeKB="), fileSizeKB);
+	FParse::Value(*Params, TEXT("BatchSize="), batchSize);
+	FParse::Value(*Params, TEXT("Runs="), numRuns);
+	batchSize = FMath::Max(batchSize, 1);
+	numRuns = FMath::Max(numRuns, 1);
+
+	TArray<FString> paths;
+	if (contentDir.IsEmpty())
+	{
+		const FString benchmarkDir = FPaths::ProjectSavedDir() / TEXT("ContentReadBenchmark");
+		if (!CreateBenchmarkFiles(benchmarkDir, numFiles, fileSizeKB, paths))
+		{
+			UE_LOG(LogContentReadBenchmark, Error, TEXT("Could not write the benchmark files to %s"), *benchmarkDir);
+			return 1;
+		}
+	}
+	else
+	{
+		IFileManager::Get().FindFilesRecursive(paths, *contentDir, TEXT("*.json"), true, false);
+	}
+	if (paths.Num() == 0)
+	{
+		UE_LOG(LogContentReadBenchmark, Error, TEXT("No file to read"));
+		return 1;
+	}
+
+	//Both readers must return the same bytes.
+	TArray<TArray<uint8>> platformContents;
+	TArray<TArray<uint8>> ioUringContents;
+	TBitArray<> platformSucceeded;
+	TBitArray<> ioUringSucceeded;
+	FContentFileReader::ReadFilesWithPlatformFile(paths, platformContents, platformSucceeded);
+	const bool withIoUring = FContentFileReader::ReadFilesWithIoUring(paths, ioUringContents, ioUringSucceeded);
+	if (!withIoUring)
+	{
+		UE_LOG(LogContentReadBenchmark, Warning, TEXT("io_uring is not available, only the platform file layer is measured"));
+	}
+	else
+	{
+		for (int i = 0; i < paths.Num(); i++)
+		{
+			if (ioUringSucceeded[i] != platformSucceeded[i] || ioUringContents[i] != platformContents[i])
+			{
+				UE_LOG(LogContentReadBenchmark, Error, TEXT("io_uring read of %s differs from the platform file layer"), *paths[i]);
+				return 1;
+			}
+		}
+	}
+
+	int64 totalBytes = 0;
+	for (const TArray<uint8>& content : platformContents)
+	{
+		totalBytes += content.Num();
+	}
+	UE_LOG(LogContentReadBenchmark, Display, TEXT("%d files, %lld KB, batches of %d, %d runs"), paths.Num(), totalBytes / 1024, batchSize, numRuns);
+
+	const auto readWithPlatformFile = [](const TArray<FString>& Batch)
+	{
+		TArray<TArray<uint8>> contents;
+		TBitArray<> succeeded;
+		FContentFileReader::ReadFilesWithPlatformFile(Batch, contents, succeeded);
+	};
+	const auto readWithIoUring = [](const TArray<FString>& Batch)
+	{
+		TArray<TArray<uint8>> contents;
+		TBitArray<> succeeded;
+		FContentFileReader::ReadFilesWithIoUring(Batch, contents, succeeded);
+	};
+
+	//The warm pass runs first, on the files the check above just read, so
+	//probing the eviction does not turn it into a cold pass.
+	for (const bool cold : { false, true })
+	{
+		if (cold && !EvictFromPageCache(paths))
+		{
+			UE_LOG(LogContentReadBenchmark, Warning, TEXT("The page cache cannot be evicted on this platform, cold reads are not measured"));
+			continue;
+		}
+
+		const TCHAR* cacheName = cold ? TEXT("Cold") : TEXT("Warm");
+		const FReadTiming platformTiming = TimeReads(paths, batchSize, numRuns, cold, readWithPlatformFile);
+		UE_LOG(LogContentReadBenchmark, Display, TEXT("%s  PlatformFile  median %.3f ms  worst %.3f ms"), cacheName, platformTiming.m_Median * 1000.0, platformTiming.m_Worst * 1000.0);
+		if (withIoUring)
+		{
+			const FReadTiming ioUringTiming = TimeReads(paths, batchSize, numRuns, cold, readWithIoUring);
+			UE_LOG(LogContentReadBenchmark, Display, TEXT("%s  IoUring       median %.3f ms  worst %.3f ms  speedup %.2fx"), cacheName,
+				ioUringTiming.m_Median * 1000.0, ioUringTiming.m_Worst * 1000.0, platformTiming.m_Median / FMath::Max(ioUringTiming.m_Median, UE_DOUBLE_SMALL_NUMBER));
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ContentReadBenchmarkCommandlet.generated.h"
+
+//Compares the batched io_uring reads of FContentFileReader with the platform
+//file layer, on the JSON files of a content directory or on synthetic files.
+//Warm runs read files already in the page cache. On Linux, cold runs evict
+//the files from the page cache before every run. Fails when both readers do
+//not return the same bytes.
+//
+//Usage: UnrealEditor-Cmd ColdWarProject -run=ContentReadBenchmark
+//	[-Content=<dir>] [-Files=200] [-FileSizeKB=16] [-BatchSize=8] [-Runs=20]
+UCLASS()
+class COLDWARPROJECT_API UContentReadBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UContentReadBenchmarkCommandlet();
+	virtual int32 Main(const FString& Params) override;
+};
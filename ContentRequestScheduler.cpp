@@ -0,0 +1,234 @@
+#include "ContentRequestScheduler.h"
+#include "GameData.h"
+#include "Async/Async.h"
+
+/*************************************
+Class: FContentRequestScheduler
+Author: Antoine Plouffe
+
+Description: Game thread queue of the content reads, run on the thread pool
+at most MaxInFlight at a time so the reads of an urgent checkpoint are not
+stuck behind a burst of prefetches. A request for a key that is pending or
+being read joins the existing request, which keeps the higher priority and
+the earlier deadline. Cancelled requests are dropped before they start,
+and a read already started only skips the callbacks of cancelled callers.
+Requests completed after their deadline are counted by priority.
+*************************************/
+
+bool FContentRequestScheduler::FRequest::IsCancelled() const
+{
+	for (const FWaiter& waiter : m_Waiters)
+	{
+		if (!waiter.m_IsCancelled->load())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+FContentRequestScheduler::FContentRequestScheduler()
+	: m_IsAlive(MakeShared<bool>(true))
+{
+	m_TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FContentRequestScheduler::OnTick));
+}
+
+//Waits for the reads still running, since they use the content caches of
+//the owner. They are single file reads, so the wait is short.
+FContentRequestScheduler::~FContentRequestScheduler()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(m_TickerHandle);
+	*m_IsAlive = false;
+	while (m_NumRunning.load() > 0)
+	{
+		FPlatformProcess::Sleep(0.0f);
+	}
+}
+
+//Queues a read. The deadline is in FPlatformTime::Seconds, or 0 for none.
+//The tag is kept with the caller for CancelIf, for instance the checkpoint
+//index the read is for, since callers of a shared key can have different
+//tags. OnDone is called on the game thread unless the token is cancelled.
+FContentRequestToken FContentRequestScheduler::Request(FName Key, EContentRequestPriority Priority, double Deadline, int32 Tag,
+	TUniqueFunction<void()>&& Work, TUniqueFunction<void()>&& OnDone)
+{
+	check(IsInGameThread());
+	FContentRequestToken token;
+	token.m_IsCancelled = MakeShared<std::atomic<bool>, ESPMode::ThreadSafe>(false);
+	FWaiter waiter { token.m_IsCancelled, Tag, MoveTemp(OnDone) };
+
+	if (FRequest* inFlight = m_InFlight.Find(Key))
+	{
+		inFlight->m_Waiters.Add(MoveTemp(waiter));
+		m_Metrics[(int32)Priority].m_Coalesced++;
+		return token;
+	}
+
+	FRequest* pending = m_Pending.FindByPredicate([Key](const FRequest& request) { return request.m_Key == Key; });
+	if (pending)
+	{
+		pending->m_Priority = FMath::Min(pending->m_Priority, Priority);
+		if (Deadline > 0.0 && (pending->m_Deadline <= 0.0 || Deadline < pending->m_Deadline))
+		{
+			pending->m_Deadline = Deadline;
+		}
+		pending->m_Waiters.Add(MoveTemp(waiter));
+		m_Metrics[(int32)Priority].m_Coalesced++;
+		return token;
+	}
+
+	FRequest& request = m_Pending.AddDefaulted_GetRef();
+	request.m_Key = Key;
+	request.m_Priority = Priority;
+	request.m_Deadline = Deadline;
+	request.m_Work = MoveTemp(Work);
+	request.m_Waiters.Add(MoveTemp(waiter));
+	Dispatch();
+	return token;
+}
+
+//Cancels the callers whose tag matches, such as the reads for checkpoints
+//the visitor can no longer reach. A pending request is dropped once all of
+//its callers are cancelled, and a read already started skips their
+//callbacks. Returns how many callers were cancelled.
+int32 FContentRequestScheduler::CancelIf(TFunctionRef<bool(int32 Tag)> Predicate)
+{
+	int32 numCancelled = 0;
+	const auto cancelWaiters = [&numCancelled, &Predicate](FRequest& request)
+	{
+		for (FWaiter& waiter : request.m_Waiters)
+		{
+			if (!waiter.m_IsCancelled->load() && Predicate(waiter.m_Tag))
+			{
+				waiter.m_IsCancelled->store(true);
+				numCancelled++;
+			}
+		}
+	};
+	for (FRequest& request : m_Pending)
+	{
+		cancelWaiters(request);
+	}
+	for (auto& inFlight : m_InFlight)
+	{
+		cancelWaiters(inFlight.Value);
+	}
+	Dispatch();
+	return numCancelled;
+}
+
+void FContentRequestScheduler::CancelAll()
+{
+	CancelIf([](int32 Tag) { return true; });
+}
+
+bool FContentRequestScheduler::OnTick(float DeltaTime)
+{
+	Dispatch();
+	return true;
+}
+
+//Drops the cancelled requests and starts the most urgent ones while
+//there is room. The queue holds a handful of requests, so it is scanned.
+void FContentRequestScheduler::Dispatch()
+{
+	for (int i = m_Pending.Num() - 1; i >= 0; i--)
+	{
+		if (m_Pending[i].IsCancelled())
+		{
+			m_Metrics[(int32)m_Pending[i].m_Priority].m_Cancelled++;
+			m_Pending.RemoveAt(i);
+		}
+	}
+
+	while (m_InFlight.Num() < MaxInFlight && m_Pending.Num() > 0)
+	{
+		int32 best = 0;
+		for (int i = 1; i < m_Pending.Num(); i++)
+		{
+			const FRequest& request = m_Pending[i];
+			const FRequest& bestRequest = m_Pending[best];
+			if (request.m_Priority != bestRequest.m_Priority)
+			{
+				if (request.m_Priority < bestRequest.m_Priority)
+				{
+					best = i;
+				}
+			}
+			else if (request.m_Deadline > 0.0 && (bestRequest.m_Deadline <= 0.0 || request.m_Deadline < bestRequest.m_Deadline))
+			{
+				best = i;
+			}
+		}
+
+		FRequest request = MoveTemp(m_Pending[best]);
+		m_Pending.RemoveAt(best);
+		const FName key = request.m_Key;
+		TUniqueFunction<void()> work = MoveTemp(request.m_Work);
+		m_InFlight.Add(key, MoveTemp(request));
+
+		m_NumRunning++;
+		Async(EAsyncExecution::ThreadPool, [this, isAlive = m_IsAlive, key, work = MoveTemp(work)]()
+		{
+			work();
+			AsyncTask(ENamedThreads::GameThread, [this, isAlive, key]()
+			{
+				if (*isAlive)
+				{
+					OnRequestDone(key);
+				}
+			});
+			m_NumRunning--;
+		});
+	}
+}
+
+void FContentRequestScheduler::OnRequestDone(FName Key)
+{
+	FRequest request;
+	if (!m_InFlight.RemoveAndCopyValue(Key, request))
+	{
+		return;
+	}
+
+	FMetrics& metrics = m_Metrics[(int32)request.m_Priority];
+	metrics.m_Completed++;
+	const double lateness = FPlatformTime::Seconds() - request.m_Deadline;
+	if (request.m_Deadline > 0.0 && lateness > 0.0)
+	{
+		metrics.m_DeadlineMisses++;
+		metrics.m_WorstLateness = FMath::Max(metrics.m_WorstLateness, lateness);
+	}
+
+	for (FWaiter& waiter : request.m_Waiters)
+	{
+		if (!waiter.m_IsCancelled->load() && waiter.m_OnDone)
+		{
+			waiter.m_OnDone();
+		}
+	}
+	Dispatch();
+}
+
+void FContentRequestScheduler::Report(FOutputDevice& Ar) const
+{
+	static const TCHAR* PriorityNames[] = { TEXT("Urgent"), TEXT("Normal"), TEXT("Prefetch") };
+	Ar.Logf(TEXT("Content requests: %d pending, %d in flight"), m_Pending.Num(), m_InFlight.Num());
+	for (int32 i = 0; i < (int32)EContentRequestPriority::Num; i++)
+	{
+		const FMetrics& metrics = m_Metrics[i];
+		Ar.Logf(TEXT("    %-8s completed %6u  coalesced %6u  cancelled %6u  deadline misses %6u  worst lateness %8.1f ms"), PriorityNames[i],
+			metrics.m_Completed, metrics.m_Coalesced, metrics.m_Cancelled, metrics.m_DeadlineMisses, metrics.m_WorstLateness * 1000.0);
+	}
+}
+
+static FAutoConsoleCommandWithOutputDevice GameDataContentRequestsCommand(
+	TEXT("GameData.ContentRequests"),
+	TEXT("Reports the content requests served, coalesced, cancelled and completed after their deadline, by priority."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		for (TObjectIterator<UGameData> it(RF_ClassDefaultObject); it; ++it)
+		{
+			it->GetContentRequests().Report(Ar);
+		}
+	}));
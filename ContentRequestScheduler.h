@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include <atomic>
+
+enum class EContentRequestPriority : uint8
+{
+	Urgent,
+	Normal,
+	Prefetch,
+	Num
+};
+
+//Cancellation token of a content request. A request is dropped before it
+//starts once every token given for it is cancelled.
+class COLDWARPROJECT_API FContentRequestToken
+{
+public:
+	FContentRequestToken() = default;
+
+	void Cancel() { if (m_IsCancelled.IsValid()) { m_IsCancelled->store(true); } }
+	bool IsCancelled() const { return m_IsCancelled.IsValid() && m_IsCancelled->load(); }
+	bool IsValid() const { return m_IsCancelled.IsValid(); }
+
+private:
+	friend class FContentRequestScheduler;
+	TSharedPtr<std::atomic<bool>, ESPMode::ThreadSafe> m_IsCancelled;
+};
+
+//Schedules the content reads of UGameData on worker threads, a few at a
+//time. Pending requests are served by priority, then by earliest deadline,
+//so the checkpoint the camera reached never waits behind prefetches.
+//Requests with the same key are coalesced into one read.
+class COLDWARPROJECT_API FContentRequestScheduler
+{
+public:
+	FContentRequestScheduler();
+	~FContentRequestScheduler();
+
+	FContentRequestToken Request(FName Key, EContentRequestPriority Priority, double Deadline, int32 Tag,
+		TUniqueFunction<void()>&& Work, TUniqueFunction<void()>&& OnDone = nullptr);
+	int32 CancelIf(TFunctionRef<bool(int32 Tag)> Predicate);
+	void CancelAll();
+	void Report(FOutputDevice& Ar) const;
+
+	static constexpr int32 MaxInFlight = 2;
+
+	struct FMetrics
+	{
+		uint32 m_Completed = 0;
+		uint32 m_Coalesced = 0;
+		uint32 m_Cancelled = 0;
+		uint32 m_DeadlineMisses = 0;
+		double m_WorstLateness = 0.0;
+	};
+	const FMetrics& GetMetrics(EContentRequestPriority Priority) const { return m_Metrics[(int32)Priority]; }
+
+private:
+	using FCancelFlag = TSharedPtr<std::atomic<bool>, ESPMode::ThreadSafe>;
+
+	//Caller waiting on a request, with its own token, tag and callback.
+	struct FWaiter
+	{
+		FCancelFlag m_IsCancelled;
+		int32 m_Tag;
+		TUniqueFunction<void()> m_OnDone;
+	};
+
+	struct FRequest
+	{
+		FName m_Key;
+		EContentRequestPriority m_Priority;
+		double m_Deadline;
+		TUniqueFunction<void()> m_Work;
+		TArray<FWaiter> m_Waiters;
+
+		bool IsCancelled() const;
+	};
+
+	bool OnTick(float DeltaTime);
+	void Dispatch();
+	void OnRequestDone(FName Key);
+
+	TArray<FRequest> m_Pending;
+	TMap<FName, FRequest> m_InFlight;
+	std::atomic<int32> m_NumRunning { 0 };
+	FMetrics m_Metrics[(int32)EContentRequestPriority::Num];
+	FTSTicker::FDelegateHandle m_TickerHandle;
+	TSharedRef<bool> m_IsAlive;
+};
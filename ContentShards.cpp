@@ -0,0 +1,100 @@
+#include "ContentShards.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+
+/*************************************
+Class: FContentShards
+Author: Antoine Plouffe
+
+Description: Maps the checkpoints of a tour to the streaming sublevel of
+their gallery, so UGameData only keeps the content of the galleries that
+are loaded. Sublevels are identified by the short name of their package,
+without the play in editor prefix, as written in the checkpoints file.
+*************************************/
+
+//Builds the shards from the sublevels read in the checkpoints JSON file.
+//Entries line up with the checkpoints. The persistent level, when used,
+//is always the first shard.
+void FContentShards::Build(const FContentShardData& ShardData, int32 NumCheckpoints)
+{
+	Reset();
+
+	TArray<FName> checkpointSublevels;
+	checkpointSublevels.Reserve(NumCheckpoints);
+	for (int i = 0; i < NumCheckpoints; i++)
+	{
+		const FString* sublevel = ShardData.Data.IsValidIndex(i) ? &ShardData.Data[i].Sublevel : nullptr;
+		checkpointSublevels.Add(sublevel && !sublevel->IsEmpty() ? FName(**sublevel) : NAME_None);
+	}
+	if (checkpointSublevels.Contains(NAME_None))
+	{
+		m_Sublevels.Add(NAME_None);
+	}
+	for (FName sublevel : checkpointSublevels)
+	{
+		m_Sublevels.AddUnique(sublevel);
+	}
+
+	//Counting sort of the checkpoints by shard.
+	m_CheckpointShards.Reserve(NumCheckpoints);
+	m_ShardOffsets.Init(0, m_Sublevels.Num() + 1);
+	for (FName sublevel : checkpointSublevels)
+	{
+		const int32 shard = m_Sublevels.IndexOfByKey(sublevel);
+		m_CheckpointShards.Add(shard);
+		m_ShardOffsets[shard + 1]++;
+	}
+	for (int i = 1; i < m_ShardOffsets.Num(); i++)
+	{
+		m_ShardOffsets[i] += m_ShardOffsets[i - 1];
+	}
+	TArray<int32> nextSlots(m_ShardOffsets.GetData(), m_Sublevels.Num());
+	m_ShardCheckpoints.SetNumUninitialized(NumCheckpoints);
+	for (int i = 0; i < NumCheckpoints; i++)
+	{
+		m_ShardCheckpoints[nextSlots[m_CheckpointShards[i]]++] = i;
+	}
+
+	m_IsResident.Init(false, m_Sublevels.Num());
+}
+
+void FContentShards::Reset()
+{
+	m_Sublevels.Empty();
+	m_CheckpointShards.Empty();
+	m_ShardOffsets.Empty();
+	m_ShardCheckpoints.Empty();
+	m_IsResident.Empty();
+}
+
+int32 FContentShards::FindShard(FName Sublevel) const
+{
+	return m_Sublevels.IndexOfByKey(Sublevel);
+}
+
+TArrayView<const int32> FContentShards::GetCheckpoints(int32 Shard) const
+{
+	if (!m_Sublevels.IsValidIndex(Shard))
+	{
+		return TArrayView<const int32>();
+	}
+	return TArrayView<const int32>(m_ShardCheckpoints.GetData() + m_ShardOffsets[Shard], m_ShardOffsets[Shard + 1] - m_ShardOffsets[Shard]);
+}
+
+SIZE_T FContentShards::GetAllocatedSize() const
+{
+	return m_Sublevels.GetAllocatedSize() + m_CheckpointShards.GetAllocatedSize() + m_ShardOffsets.GetAllocatedSize()
+		+ m_ShardCheckpoints.GetAllocatedSize() + m_IsResident.GetAllocatedSize();
+}
+
+//Returns the name a level is referred to in the checkpoints file,
+//or None for the persistent level.
+FName FContentShards::GetSublevelName(const ULevel* Level)
+{
+	if (!Level || Level->IsPersistentLevel())
+	{
+		return NAME_None;
+	}
+	return FName(*UWorld::RemovePIEPrefix(FPackageName::GetShortName(Level->GetOutermost()->GetName())));
+}
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ContentShards.generated.h"
+
+//Optional streaming sublevel of a checkpoint, read from the checkpoints
+//JSON file. Checkpoints without a sublevel belong to the persistent level.
+USTRUCT()
+struct FContentShardEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		FString Sublevel;
+};
+
+USTRUCT()
+struct FContentShardData
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<FContentShardEntry> Data;
+};
+
+//Partition of the checkpoints of a tour by streaming sublevel (one shard
+//per gallery). The checkpoints of a shard are stored in a compact offset
+//table and the shards whose sublevel is resident are kept in a bitset.
+class COLDWARPROJECT_API FContentShards
+{
+public:
+	void Build(const FContentShardData& ShardData, int32 NumCheckpoints);
+	void Reset();
+
+	int32 Num() const { return m_Sublevels.Num(); }
+	int32 FindShard(FName Sublevel) const;
+	int32 GetShard(int32 CheckpointIndex) const { return m_CheckpointShards.IsValidIndex(CheckpointIndex) ? m_CheckpointShards[CheckpointIndex] : INDEX_NONE; }
+	FName GetSublevel(int32 Shard) const { return m_Sublevels[Shard]; }
+	bool IsPersistent(int32 Shard) const { return m_Sublevels[Shard].IsNone(); }
+	TArrayView<const int32> GetCheckpoints(int32 Shard) const;
+	bool IsResident(int32 Shard) const { return m_IsResident[Shard]; }
+	void SetResident(int32 Shard, bool bResident) { m_IsResident[Shard] = bResident; }
+	SIZE_T GetAllocatedSize() const;
+
+	static FName GetSublevelName(const ULevel* Level);
+
+private:
+	TArray<FName> m_Sublevels;
+	TArray<int32> m_CheckpointShards;
+	TArray<int32> m_ShardOffsets;
+	TArray<int32> m_ShardCheckpoints;
+	TBitArray<> m_IsResident;
+};
@@ -0,0 +1,324 @@
+#include "ContentValidationCommandlet.h"
+#include "ResolvedReferences.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Level.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "JsonObjectConverter.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Sound/SoundBase.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogContentValidation, Log, All);
+
+/*************************************
+Class: UContentValidationCommandlet
+Author: Antoine Plouffe
+
+Description: Offline counterpart of GetActorByName, GetSoundByName and
+GetImageByName. The assets of the asset registry and the actors of the
+given maps and of their streaming sublevels are gathered first. Then
+every JSON file of the content directory is read, parsed, walked for
+sound, image and checkpoint names and resolved in parallel, one file per
+task. All the problems are logged at once, and the resolved references
+are written to a table that UGameData reads to skip name matching in
+shipping builds.
+*************************************/
+
+namespace
+{
+	enum class EReferenceKind : uint8
+	{
+		Sound,
+		Image,
+		Checkpoint,
+	};
+
+	struct FContentReference
+	{
+		EReferenceKind m_Kind;
+		FString m_Name;
+		FString m_File;
+	};
+
+	//References of one content file, with the path each one resolved to.
+	struct FContentFileReferences
+	{
+		TArray<FContentReference> m_References;
+		TArray<const FString*> m_ResolvedPaths;
+		bool m_IsValid = false;
+	};
+
+	//Classifies a JSON field by its name, following the names used by the
+	//instructions, checkpoints, learn more and quiz files.
+	bool GetReferenceKind(const FString& FieldName, EReferenceKind& OutKind)
+	{
+		if (FieldName.Contains(TEXT("NarrationSound")))
+		{
+			OutKind = EReferenceKind::Sound;
+			return true;
+		}
+		if (FieldName == TEXT("ImagesNames"))
+		{
+			OutKind = EReferenceKind::Image;
+			return true;
+		}
+		if (FieldName == TEXT("CheckpointName") || FieldName == TEXT("NextCheckpointNames"))
+		{
+			OutKind = EReferenceKind::Checkpoint;
+			return true;
+		}
+		return false;
+	}
+
+	void CollectReferences(const TSharedPtr<FJsonValue>& Value, const FString& File, TArray<FContentReference>& OutReferences)
+	{
+		if (!Value.IsValid())
+		{
+			return;
+		}
+
+		if (Value->Type == EJson::Array)
+		{
+			for (const TSharedPtr<FJsonValue>& element : Value->AsArray())
+			{
+				CollectReferences(element, File, OutReferences);
+			}
+			return;
+		}
+
+		if (Value->Type != EJson::Object)
+		{
+			return;
+		}
+
+		for (const TPair<FString, TSharedPtr<FJsonValue>>& field : Value->AsObject()->Values)
+		{
+			EReferenceKind kind;
+			if (!GetReferenceKind(field.Key, kind))
+			{
+				CollectReferences(field.Value, File, OutReferences);
+				continue;
+			}
+
+			TArray<FString> names;
+			if (field.Value->Type == EJson::String)
+			{
+				names.Add(field.Value->AsString());
+			}
+			else if (field.Value->Type == EJson::Array)
+			{
+				for (const TSharedPtr<FJsonValue>& element : field.Value->AsArray())
+				{
+					names.Add(element->AsString());
+				}
+			}
+
+			for (const FString& name : names)
+			{
+				if (!name.IsEmpty())
+				{
+					OutReferences.Add({ kind, name, File });
+				}
+			}
+		}
+	}
+
+	//Maps the asset names of a class to their object paths. Names used by
+	//more than one asset are reported, since runtime matching takes the first.
+	TMap<FString, FString> GetAssetPathsByName(IAssetRegistry& AssetRegistry, UClass* AssetClass, TArray<FString>& OutProblems)
+	{
+		TArray<FAssetData> assets;
+		AssetRegistry.GetAssetsByClass(AssetClass->GetClassPathName(), assets, true);
+
+		TMap<FString, FString> pathsByName;
+		for (const FAssetData& asset : assets)
+		{
+			const FString name = asset.AssetName.ToString();
+			const FString path = asset.GetSoftObjectPath().ToString();
+			if (const FString* existing = pathsByName.Find(name))
+			{
+				OutProblems.Add(FString::Printf(TEXT("Ambiguous %s name %s: %s and %s"), *AssetClass->GetName(), *name, **existing, *path));
+				continue;
+			}
+			pathsByName.Add(name, path);
+		}
+		return pathsByName;
+	}
+
+	UWorld* LoadMap(const FString& MapPackage)
+	{
+		UPackage* package = LoadPackage(nullptr, *MapPackage, LOAD_None);
+		UWorld* world = package ? UWorld::FindWorldInPackage(package) : nullptr;
+		return world && world->PersistentLevel ? world : nullptr;
+	}
+
+	//Maps the checkpoint names (first tag of the actors, as used by
+	//GetActorByName) of the given maps and of their streaming sublevels,
+	//one per gallery, to the actor paths. Names used by more than one
+	//actor are reported.
+	TMap<FString, FString> GetCheckpointPathsByName(const TArray<FString>& MapPackages, TArray<FString>& OutProblems)
+	{
+		TMap<FString, FString> pathsByName;
+		const auto addActors = [&pathsByName, &OutProblems](const ULevel* Level)
+		{
+			for (AActor* actor : Level->Actors)
+			{
+				if (!actor || actor->Tags.Num() == 0)
+				{
+					continue;
+				}
+				const FString name = actor->Tags[0].ToString();
+				const FString path = FSoftObjectPath(actor).ToString();
+				if (const FString* existing = pathsByName.Find(name))
+				{
+					OutProblems.Add(FString::Printf(TEXT("Ambiguous Checkpoint name %s: %s and %s"), *name, **existing, *path));
+					continue;
+				}
+				pathsByName.Add(name, path);
+			}
+		};
+
+		for (const FString& mapPackage : MapPackages)
+		{
+			UWorld* world = LoadMap(mapPackage);
+			if (!world)
+			{
+				OutProblems.Add(FString::Printf(TEXT("Map Not Found %s"), *mapPackage));
+				continue;
+			}
+			addActors(world->PersistentLevel);
+
+			for (const ULevelStreaming* streamingLevel : world->GetStreamingLevels())
+			{
+				const FString sublevelPackage = streamingLevel ? streamingLevel->GetWorldAssetPackageName() : FString();
+				UWorld* sublevel = sublevelPackage.IsEmpty() ? nullptr : LoadMap(sublevelPackage);
+				if (!sublevel)
+				{
+					OutProblems.Add(FString::Printf(TEXT("Sublevel Not Found %s (%s)"), *sublevelPackage, *mapPackage));
+					continue;
+				}
+				addActors(sublevel->PersistentLevel);
+			}
+		}
+		return pathsByName;
+	}
+}
+
+UContentValidationCommandlet::UContentValidationCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UContentValidationCommandlet::Main(const FString& Params)
+{
+	FString contentDir = FPaths::ProjectContentDir() / TEXT("JSONFiles");
+	FString outputPath = contentDir / TEXT("ResolvedReferences.json");
+	FString maps;
+	FParse::Value(*Params, TEXT("Content="), contentDir);
+	FParse::Value(*Params, TEXT("Output="), outputPath);
+	FParse::Value(*Params, TEXT("Maps="), maps);
+
+	TArray<FString> problems;
+
+	//Gather what the references can resolve to. Maps are loaded on the
+	//game thread, before the files are processed.
+	IAssetRegistry& assetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	assetRegistry.SearchAllAssets(true);
+	const TMap<FString, FString> soundPaths = GetAssetPathsByName(assetRegistry, USoundBase::StaticClass(), problems);
+	const TMap<FString, FString> imagePaths = GetAssetPathsByName(assetRegistry, UTexture2D::StaticClass(), problems);
+	TArray<FString> mapPackages;
+	maps.ParseIntoArray(mapPackages, TEXT("+"));
+	const TMap<FString, FString> checkpointPaths = GetCheckpointPathsByName(mapPackages, problems);
+
+	//Read, parse and resolve the content files in parallel, one file per
+	//task, the lookup tables being read only.
+	TArray<FString> files;
+	IFileManager::Get().FindFilesRecursive(files, *contentDir, TEXT("*.json"), true, false);
+	files.RemoveAll([&outputPath](const FString& file) { return FPaths::GetCleanFilename(file) == FPaths::GetCleanFilename(outputPath); });
+
+	TArray<FContentFileReferences> fileReferences;
+	fileReferences.SetNum(files.Num());
+	ParallelFor(files.Num(), [&](int32 fileIndex)
+	{
+		FContentFileReferences& result = fileReferences[fileIndex];
+		FString jsonString;
+		TSharedPtr<FJsonValue> root;
+		if (!FFileHelper::LoadFileToString(jsonString, *files[fileIndex]) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(jsonString), root))
+		{
+			return;
+		}
+		result.m_IsValid = true;
+		CollectReferences(root, files[fileIndex], result.m_References);
+
+		result.m_ResolvedPaths.SetNumZeroed(result.m_References.Num());
+		for (int i = 0; i < result.m_References.Num(); i++)
+		{
+			const FContentReference& reference = result.m_References[i];
+			switch (reference.m_Kind)
+			{
+			case EReferenceKind::Sound: result.m_ResolvedPaths[i] = soundPaths.Find(reference.m_Name); break;
+			case EReferenceKind::Image: result.m_ResolvedPaths[i] = imagePaths.Find(reference.m_Name); break;
+			case EReferenceKind::Checkpoint: result.m_ResolvedPaths[i] = checkpointPaths.Find(reference.m_Name); break;
+			}
+		}
+	});
+
+	FResolvedReferenceTable table;
+	int32 numReferences = 0;
+	static const TCHAR* KindNames[] = { TEXT("Sound"), TEXT("Image"), TEXT("Checkpoint") };
+	for (int fileIndex = 0; fileIndex < files.Num(); fileIndex++)
+	{
+		const FContentFileReferences& result = fileReferences[fileIndex];
+		if (!result.m_IsValid)
+		{
+			problems.Add(FString::Printf(TEXT("Invalid JSON %s"), *files[fileIndex]));
+			continue;
+		}
+
+		numReferences += result.m_References.Num();
+		for (int i = 0; i < result.m_References.Num(); i++)
+		{
+			const FContentReference& reference = result.m_References[i];
+			const FString* resolvedPath = result.m_ResolvedPaths[i];
+			if (!resolvedPath)
+			{
+				if (reference.m_Kind != EReferenceKind::Checkpoint || mapPackages.Num() > 0)
+				{
+					problems.AddUnique(FString::Printf(TEXT("%s Not Found %s (%s)"), KindNames[(int32)reference.m_Kind], *reference.m_Name, *reference.m_File));
+				}
+				continue;
+			}
+
+			switch (reference.m_Kind)
+			{
+			case EReferenceKind::Sound: table.Sounds.Add(reference.m_Name, *resolvedPath); break;
+			case EReferenceKind::Image: table.Images.Add(reference.m_Name, *resolvedPath); break;
+			case EReferenceKind::Checkpoint: table.Checkpoints.Add(reference.m_Name, *resolvedPath); break;
+			}
+		}
+	}
+
+	for (const FString& problem : problems)
+	{
+		UE_LOG(LogContentValidation, Error, TEXT("%s"), *problem);
+	}
+	UE_LOG(LogContentValidation, Display, TEXT("%d files, %d references, %d problems"), files.Num(), numReferences, problems.Num());
+
+	FString tableString;
+	if (!FJsonObjectConverter::UStructToJsonObjectString(table, tableString) || !FFileHelper::SaveStringToFile(tableString, *outputPath))
+	{
+		UE_LOG(LogContentValidation, Error, TEXT("Could not write %s"), *outputPath);
+		return 1;
+	}
+
+	return problems.Num() > 0 ? 1 : 0;
+}
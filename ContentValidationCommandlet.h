@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ContentValidationCommandlet.generated.h"
+
+//Validates every tour content file against the project assets and maps,
+//including their streaming sublevels, in one pass, and writes the table of the resolved references used by the
+//shipping builds instead of matching names at runtime.
+//
+//Usage: UnrealEditor-Cmd ColdWarProject -run=ContentValidation
+//	[-Content=<dir>] [-Maps=/Game/Maps/A+/Game/Maps/B] [-Output=<file>]
+UCLASS()
+class COLDWARPROJECT_API UContentValidationCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UContentValidationCommandlet();
+	virtual int32 Main(const FString& Params) override;
+};
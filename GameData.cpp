@@ -4,6 +4,16 @@
 #include "Components/HorizontalBoxSlot.h"
 #include "Components/Image.h"
 #include "Components/ProgressBar.h"
+#include "Async/Async.h"
+#include "Internationalization/Internationalization.h"
+#include "QuizAnalytics.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Engine/Texture2D.h"
+#include "Sound/SoundBase.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "AudioDevice.h"
+#include "Sound/SoundWave.h"
 
 /*************************************
 Class: UGameData
@@ -16,9 +26,40 @@ functions for populating UI elements, such as progress bars and quiz options, ba
 on the loaded data. The class encapsulates error handling to display debug messages in case of data loading issues.
 *************************************/
 
+static TAutoConsoleVariable<float> CVarGameDataCameraFrameRate(
+	TEXT("GameData.CameraFrameRate"),
+	30.0f,
+	TEXT("Frame rate of the tour camera sequence, used to turn checkpoint frame numbers into content request deadlines."));
+
+//Empties the sound lists of a narration UGameData keeps for itself, its
+//sounds being held once in the asset list pool through its handles.
+template<typename TNarration>
+static void StripAssetLists(TNarration& Narration)
+{
+	Narration.m_EnglishNarrationSounds.Empty();
+	Narration.m_FrenchNarrationSounds.Empty();
+}
+
 void UGameData::GameData()
 {
 	m_JsonHelper = NewObject<UJsonHelper>();
+	FInternationalization::Get().OnCultureChanged().AddUObject(this, &UGameData::OnCultureChanged);
+
+	FString replayPath;
+	if (FParse::Value(FCommandLine::Get(), TEXT("RecordTourReplay="), replayPath))
+	{
+		m_ReplayRecorder.Start(replayPath);
+	}
+
+	//Nothing is loaded yet, the table is shared once resolved.
+	if (FParse::Param(FCommandLine::Get(), TEXT("SharedGameData")))
+	{
+		ShareCaptionTexts();
+	}
+
+#if UE_BUILD_SHIPPING
+	LoadResolvedReferences(FPaths::ProjectContentDir() + "/JSONFiles/ResolvedReferences.json");
+#endif
 }
 
 //-----------------------------------\\
@@ -27,37 +68,50 @@ void UGameData::GameData()
 //--                               --\\
 //-----------------------------------\\
 
-//Read instruction data from a JSON file specified by the given path.
+//Read instruction data from a JSON file specified by the given path,
+//going through the parse cache so unchanged files are not parsed again.
 //It creates a structured representation of the instruction data, mapping
 //instruction types to their corresponding narration keys and sound assets.
 //Additionally, it handles error reporting by displaying debug messages
-//if any issues occur during the data loading process.
+//if any issues occur during the data loading process. The loaded data
+//also feeds the instruction scheduler used for the timed instructions.
 FInstructionGameData UGameData::LoadInstructionsData(UWorld* World, FString path, TArray<USoundBase*> NarrativeSounds)
 {
-	bool success;
-	FString message;
+	m_ReplayRecorder.Record(ETourReplayAction::LoadInstructions, INDEX_NONE, INDEX_NONE, path);
 
-	FInstructionsData dataStructure = m_JsonHelper->ReadStructFromJsonFile<FInstructionsData>(path, success, message);
-	FInstructionGameData instructionData;
-	for (int i = 0; i < dataStructure.Data.Num(); i++)
+	return m_InstructionsLoader.Load(GetLoadEnvironment(), path, INDEX_NONE, [&](const FInstructionsData& dataStructure, const FContentLoadContext& context)
 	{
-		FInstructionNarration narrationKeys;
-		narrationKeys.m_TitleKey = dataStructure.Data[i].TitleCaptionKey;
-		for (auto captionKey : dataStructure.Data[i].CaptionKeys)
+		FCaptionTimingData timingData = context.Read<FCaptionTimingData>();
+		FInstructionGameData instructionData;
+		SyncSoundNames(NarrativeSounds);
+		m_InstructionCaptionTimelines.Empty();
+		m_InstructionCaptionIds.Empty();
+		m_InstructionAssetLists.Empty();
+		for (int i = 0; i < dataStructure.Data.Num(); i++)
 		{
-			narrationKeys.m_Keys.Add(captionKey);
+			FInstructionNarration narrationKeys;
+			narrationKeys.m_TitleKey = dataStructure.Data[i].TitleCaptionKey;
+			for (auto captionKey : dataStructure.Data[i].CaptionKeys)
+			{
+				narrationKeys.m_Keys.Add(captionKey);
+			}
+			narrationKeys.m_EnglishNarrationSounds = FindSounds(dataStructure.Data[i].EnglishNarrationSoundNames);
+			narrationKeys.m_FrenchNarrationSounds = FindSounds(dataStructure.Data[i].FrenchNarrationSoundNames);
+			instructionData.InstructionKeyMap.Add(StringToInstructions(dataStructure.Data[i].InstructionType), narrationKeys);
+			m_InstructionCaptionTimelines.Add(StringToInstructions(dataStructure.Data[i].InstructionType),
+				BuildCaptionTimelines(timingData, i, narrationKeys.m_Keys.Num(), narrationKeys.m_EnglishNarrationSounds, narrationKeys.m_FrenchNarrationSounds));
+			m_InstructionCaptionIds.Add(StringToInstructions(dataStructure.Data[i].InstructionType), RegisterCaptionIds(narrationKeys.m_TitleKey, narrationKeys.m_Keys));
+			m_InstructionAssetLists.Add(StringToInstructions(dataStructure.Data[i].InstructionType), InternAssetLists(narrationKeys.m_EnglishNarrationSounds, narrationKeys.m_FrenchNarrationSounds));
 		}
-		narrationKeys.m_EnglishNarrationSounds = GetSoundByName(dataStructure.Data[i].EnglishNarrationSoundNames, NarrativeSounds);
-		narrationKeys.m_FrenchNarrationSounds = GetSoundByName(dataStructure.Data[i].FrenchNarrationSoundNames, NarrativeSounds);
-		instructionData.InstructionKeyMap.Add(StringToInstructions(dataStructure.Data[i].InstructionType), narrationKeys);
-
-		if (!success)
+		m_CaptionTexts.Resolve();
+		FInstructionGameData scheduledData = instructionData;
+		for (auto& narration : scheduledData.InstructionKeyMap)
 		{
-			if (GEngine) GEngine->AddOnScreenDebugMessage(-1, 60.0f, FColor::Green, message);
+			StripAssetLists(narration.Value);
 		}
-	}
-
-	return instructionData;
+		m_InstructionScheduler.SetInstructions(scheduledData);
+		return instructionData;
+	});
 }
 
 //-----------------------------------\\
@@ -71,46 +125,324 @@ FInstructionGameData UGameData::LoadInstructionsData(UWorld* World, FString path
 //actors to follow, their associated frame numbers, and narration keys with
 //relevant sound assets. Additionally, the method populates the game data
 //structure with information about whether a checkpoint has associated
-//learn more options or quizzes. Error handling is incorporated to display
-//debug messages in case of loading issues.
+//learn more options or quizzes, also kept as bitsets over the checkpoint
+//indices for fast feature queries. The optional branching of the tour is
+//read from the same file to build the tour graph. Error handling is
+//incorporated to display debug messages in case of loading issues.
 FCheckpointsGameData UGameData::LoadCheckpointsData(UWorld* World, FString path, TArray<USoundBase*> NarrativeSounds, TArray<AActor*> CPActors)
 {
-	bool success;
-	FString message;
+	return LoadCheckpointsData(World, FJsonContentFile(path), NarrativeSounds, CPActors);
+}
 
-	FCheckpointsGameData gameData;
-	static FCheckpointsData DataStructure = m_JsonHelper->ReadStructFromJsonFile<FCheckpointsData>(path, success, message);
+//Same as LoadCheckpointsData for a file a worker step already read.
+FCheckpointsGameData UGameData::LoadCheckpointsData(UWorld* World, const FJsonContentFile& File, const TArray<USoundBase*>& NarrativeSounds, const TArray<AActor*>& CPActors)
+{
+	const FString& path = File.GetPath();
+	m_ReplayRecorder.Record(ETourReplayAction::LoadCheckpoints, INDEX_NONE, INDEX_NONE, path);
+
+	return m_CheckpointsLoader.Load(GetLoadEnvironment(), File, INDEX_NONE, [&](const FCheckpointsData& DataStructure, const FContentLoadContext& context)
+	{
+		FCheckpointsGameData gameData;
+		FCaptionTimingData timingData = context.Read<FCaptionTimingData>();
+		m_ActiveTour.m_CaptionTimelines.Empty();
+		m_ActiveTour.m_CaptionIds.Empty();
+		m_ActiveTour.m_AssetLists.Empty();
+		m_ActiveTour.m_CheckpointIndices.Empty();
+		m_ActiveTour.m_Flags.Reset(DataStructure.Data.Num());
+		ResetShardedTour();
+		const uint32 tourKey = FCrc::StrCrc32(*path, DataStructure.Data.Num());
+		if (m_SessionState.m_TourKey != tourKey)
+		{
+			m_SessionState.Reset(tourKey);
+		}
+		TArray<int32> frameNumbers;
+		SyncSoundNames(NarrativeSounds);
+
+		for (int i = 0; i < DataStructure.Data.Num(); i++)
+		{
+			bool success;
+			FString message;
+			AActor* actor = GetCheckpointActor(DataStructure.Data[i].CheckpointName, CPActors, World, success, message);
+			context.Check(success, message);
+
+			gameData.ActorsToFollow.Add(actor);
+			gameData.ActorFrameMap.Add(actor, DataStructure.Data[i].CheckpointFrameNumber);
+			frameNumbers.Add(DataStructure.Data[i].CheckpointFrameNumber);
+
+			FNarrationKeys narrationKeys = LoadCheckpointNarration(m_ActiveTour, DataStructure, timingData, i, actor);
+			m_ActiveTour.m_Flags.Set(i, ECheckpointFlag::ShouldStopCamera, narrationKeys.m_ShouldStopCamera);
+			m_ActiveTour.m_Flags.Set(i, ECheckpointFlag::HasLearnMoreOption, narrationKeys.m_HasLearnMoreOption);
+			m_ActiveTour.m_Flags.Set(i, ECheckpointFlag::HasQuiz, narrationKeys.m_HasQuiz);
+			gameData.ActorKeyMap.Add(actor, narrationKeys);
+		}
+		m_CaptionTexts.Resolve();
+		RequestCaptionSearchRebuild();
+
+		FTourGraphData graphData = context.Read<FTourGraphData>();
+		FString message;
+		context.Check(m_ActiveTour.m_Graph.Build(graphData, frameNumbers, message), message);
+		m_ActiveTour.m_FrameNumbers = MoveTemp(frameNumbers);
+		CompactAssetLists();
+		return gameData;
+	});
+}
+
+//Builds the narration of a checkpoint and the caption timelines, caption
+//ids and asset lists kept for its actor in the given tour. The sounds are
+//found in the narrative sounds the caller synced the sound index with.
+FNarrationKeys UGameData::LoadCheckpointNarration(FTourState& Tour, const FCheckpointsData& DataStructure, const FCaptionTimingData& TimingData, int Index, AActor* Actor)
+{
+	const auto& data = DataStructure.Data[Index];
+	FNarrationKeys narrationKeys;
+	narrationKeys.m_TitleKey = data.TitleCaptionKey;
+	for (auto captionKey : data.CaptionKeys)
+	{
+		narrationKeys.m_Keys.Add(captionKey);
+	}
+	narrationKeys.m_EnglishNarrationSounds = FindSounds(data.EnglishNarrationSoundNames);
+	narrationKeys.m_FrenchNarrationSounds = FindSounds(data.FrenchNarrationSoundNames);
+	narrationKeys.m_ShouldStopCamera = data.ShouldStopCamera;
+	narrationKeys.m_HasLearnMoreOption = data.HasLearnMoreOption;
+	narrationKeys.m_HasQuiz = data.HasQuiz;
+	narrationKeys.m_NumOfLearnMoreOptions = data.NumOfLearnMoreOption;
+
+	Tour.m_CaptionTimelines.Add(Actor,
+		BuildCaptionTimelines(TimingData, Index, narrationKeys.m_Keys.Num(), narrationKeys.m_EnglishNarrationSounds, narrationKeys.m_FrenchNarrationSounds));
+	Tour.m_CaptionIds.Add(Actor, RegisterCaptionIds(narrationKeys.m_TitleKey, narrationKeys.m_Keys));
+	Tour.m_AssetLists.Add(Actor, InternAssetLists(narrationKeys.m_EnglishNarrationSounds, narrationKeys.m_FrenchNarrationSounds));
+	Tour.m_CheckpointIndices.Add(Actor, Index);
+	return narrationKeys;
+}
+
+//Same as LoadCheckpointsData for a map split in streaming sublevels, one
+//per gallery. The flags and the graph cover the whole tour, but narrations
+//are only built for the checkpoints of the sublevels that are loaded, and
+//are built or dropped as sublevels stream in and out (see OnContentShardChanged).
+//The file is parsed once here, and the shards are built from the rows kept.
+//ActorsToFollow keeps one entry per checkpoint, null while not loaded.
+FCheckpointsGameData UGameData::LoadCheckpointsDataSharded(UWorld* World, FString path, TArray<USoundBase*> NarrativeSounds)
+{
+	m_ReplayRecorder.Record(ETourReplayAction::LoadCheckpoints, INDEX_NONE, INDEX_NONE, path);
 
-	for (int i = 0; i < DataStructure.Data.Num(); i++)
+	//The shards measure their own content as they are loaded.
+	FContentLoadEnvironment environment = GetLoadEnvironment();
+	environment.m_ContentMemory = nullptr;
+	return m_CheckpointsShardedLoader.Load(environment, path, INDEX_NONE, [&](const FCheckpointsData& DataStructure, const FContentLoadContext& context)
 	{
-		AActor* actor = GetActorByName(DataStructure.Data[i].CheckpointName, CPActors, World, success, message);
+		FContentShardData shardData = context.Read<FContentShardData>();
+		m_ActiveTour.m_CaptionTimelines.Empty();
+		m_ActiveTour.m_CaptionIds.Empty();
+		m_ActiveTour.m_AssetLists.Empty();
+		m_ActiveTour.m_CheckpointIndices.Empty();
+		m_ActiveTour.m_Flags.Reset(DataStructure.Data.Num());
+		CompactAssetLists();
+		const uint32 tourKey = FCrc::StrCrc32(*path, DataStructure.Data.Num());
+		if (m_SessionState.m_TourKey != tourKey)
+		{
+			m_SessionState.Reset(tourKey);
+		}
+
+		TArray<int32> frameNumbers;
+		for (int i = 0; i < DataStructure.Data.Num(); i++)
+		{
+			frameNumbers.Add(DataStructure.Data[i].CheckpointFrameNumber);
+			m_ActiveTour.m_Flags.Set(i, ECheckpointFlag::ShouldStopCamera, DataStructure.Data[i].ShouldStopCamera);
+			m_ActiveTour.m_Flags.Set(i, ECheckpointFlag::HasLearnMoreOption, DataStructure.Data[i].HasLearnMoreOption);
+			m_ActiveTour.m_Flags.Set(i, ECheckpointFlag::HasQuiz, DataStructure.Data[i].HasQuiz);
+		}
 
-		gameData.ActorsToFollow.Add(actor);
-		gameData.ActorFrameMap.Add(actor, DataStructure.Data[i].CheckpointFrameNumber);
+		FTourGraphData graphData = context.Read<FTourGraphData>();
+		FString message;
+		context.Check(m_ActiveTour.m_Graph.Build(graphData, frameNumbers, message), message);
+		m_ActiveTour.m_FrameNumbers = MoveTemp(frameNumbers);
+
+		m_ContentShards.Build(shardData, DataStructure.Data.Num());
+		m_ShardedCheckpoints = DataStructure;
+		m_ShardedTimings = context.Read<FCaptionTimingData>();
+		m_ShardedPath = path;
+		m_ShardedSounds = NarrativeSounds;
+		m_ShardedWorld = World;
+		m_ShardedActors.Init(nullptr, DataStructure.Data.Num());
+		if (!m_LevelAddedHandle.IsValid())
+		{
+			m_LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UGameData::OnLevelAddedToWorld);
+			m_LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UGameData::OnLevelRemovedFromWorld);
+		}
+
+		FCheckpointsGameData gameData;
+		gameData.ActorsToFollow.Init(nullptr, DataStructure.Data.Num());
+		if (World)
+		{
+			for (ULevel* level : World->GetLevels())
+			{
+				const int32 shard = m_ContentShards.FindShard(FContentShards::GetSublevelName(level));
+				if (shard == INDEX_NONE || !level->bIsVisible)
+				{
+					continue;
+				}
+				const FCheckpointsGameData shardGameData = LoadCheckpointShard(shard, level, &context);
+				for (int32 checkpointIndex : m_ContentShards.GetCheckpoints(shard))
+				{
+					gameData.ActorsToFollow[checkpointIndex] = shardGameData.ActorsToFollow[checkpointIndex];
+				}
+				gameData.ActorFrameMap.Append(shardGameData.ActorFrameMap);
+				gameData.ActorKeyMap.Append(shardGameData.ActorKeyMap);
+			}
+		}
+		return gameData;
+	});
+}
+
+//Builds the narrations of the checkpoints of a shard from the rows kept
+//by LoadCheckpointsDataSharded, whose actors are looked up in the level of
+//the shard only. Problems are reported with the tour when it is loading,
+//or on their own when the sublevel streams in later.
+FCheckpointsGameData UGameData::LoadCheckpointShard(int32 Shard, ULevel* Level, const FContentLoadContext* TourContext)
+{
+	FGameDataLatencyScope latencyScope(TEXT("LoadCheckpointShard"), m_SessionState);
+	LLM_SCOPE_BYTAG(GameData);
+
+	TArray<AActor*> levelActors;
+	for (AActor* actor : Level->Actors)
+	{
+		if (actor && actor->Tags.Num() > 0)
+		{
+			levelActors.Add(actor);
+		}
+	}
 
-		FNarrationKeys narrationKeys;
-		narrationKeys.m_TitleKey = DataStructure.Data[i].TitleCaptionKey;
-		for (auto captionKey : DataStructure.Data[i].CaptionKeys)
+	FContentDiagnostics diagnostics;
+	FCheckpointsGameData gameData;
+	gameData.ActorsToFollow.Init(nullptr, m_ShardedCheckpoints.Data.Num());
+	SyncSoundNames(m_ShardedSounds);
+	for (int32 checkpointIndex : m_ContentShards.GetCheckpoints(Shard))
+	{
+		if (!m_ShardedCheckpoints.Data.IsValidIndex(checkpointIndex))
 		{
-			narrationKeys.m_Keys.Add(captionKey);
+			continue;
 		}
-		narrationKeys.m_EnglishNarrationSounds = GetSoundByName(DataStructure.Data[i].EnglishNarrationSoundNames, NarrativeSounds);
-		narrationKeys.m_FrenchNarrationSounds = GetSoundByName(DataStructure.Data[i].FrenchNarrationSoundNames, NarrativeSounds);
-		narrationKeys.m_ShouldStopCamera = DataStructure.Data[i].ShouldStopCamera;
-		narrationKeys.m_HasLearnMoreOption = DataStructure.Data[i].HasLearnMoreOption;
-		narrationKeys.m_HasQuiz = DataStructure.Data[i].HasQuiz;
-		narrationKeys.m_NumOfLearnMoreOptions = DataStructure.Data[i].NumOfLearnMoreOption;
-		gameData.ActorKeyMap.Add(actor, narrationKeys);
 
+		bool success;
+		FString message;
+		AActor* actor = GetCheckpointActor(m_ShardedCheckpoints.Data[checkpointIndex].CheckpointName, levelActors, Level->GetWorld(), success, message);
 		if (!success)
 		{
-			if (GEngine) GEngine->AddOnScreenDebugMessage(-1, 60.0f, FColor::Green, message);
+			if (TourContext)
+			{
+				TourContext->Check(success, message);
+			}
+			else
+			{
+				diagnostics.Add(message);
+			}
+			continue;
 		}
+
+		gameData.ActorsToFollow[checkpointIndex] = actor;
+		gameData.ActorFrameMap.Add(actor, m_ShardedCheckpoints.Data[checkpointIndex].CheckpointFrameNumber);
+		gameData.ActorKeyMap.Add(actor, LoadCheckpointNarration(m_ActiveTour, m_ShardedCheckpoints, m_ShardedTimings, checkpointIndex, actor));
+		m_ShardedActors[checkpointIndex] = actor;
 	}
+	m_CaptionTexts.Resolve();
+	RequestCaptionSearchRebuild();
+	diagnostics.Report(TEXT("LoadCheckpointShard"), m_ShardedPath);
+	m_ContentShards.SetResident(Shard, true);
 
+	const FString contentKey = m_ShardedPath + TEXT(":") + m_ContentShards.GetSublevel(Shard).ToString();
+	m_ContentMemory.FindOrAdd(contentKey) = FGameDataMemoryReport();
+	m_ContentMemory[contentKey].Measure(gameData);
 	return gameData;
 }
 
+//Forgets the sharded tour once another tour replaces it, so streaming
+//sublevels no longer build narrations into the active tour.
+void UGameData::ResetShardedTour()
+{
+	m_ContentShards.Reset();
+	m_ShardedCheckpoints = FCheckpointsData();
+	m_ShardedTimings = FCaptionTimingData();
+	m_ShardedPath.Empty();
+	m_ShardedSounds.Empty();
+	m_ShardedWorld.Reset();
+	m_ShardedActors.Empty();
+	FWorldDelegates::LevelAddedToWorld.Remove(m_LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(m_LevelRemovedHandle);
+	m_LevelAddedHandle.Reset();
+	m_LevelRemovedHandle.Reset();
+}
+
+//Drops what was built for the checkpoints of a shard, including the learn
+//more entries and quiz tiles populated for one of them. The caption ids of
+//the checkpoints are released, so texts no other content uses are freed.
+void UGameData::UnloadCheckpointShard(int32 Shard)
+{
+	for (int32 checkpointIndex : m_ContentShards.GetCheckpoints(Shard))
+	{
+		if (AActor* actor = m_ShardedActors[checkpointIndex])
+		{
+			FNarrationCaptionIds captionIds;
+			if (m_ActiveTour.m_CaptionIds.RemoveAndCopyValue(actor, captionIds))
+			{
+				ReleaseCaptionIds(captionIds);
+			}
+			m_ActiveTour.m_CaptionTimelines.Remove(actor);
+			m_ActiveTour.m_AssetLists.Remove(actor);
+			m_ActiveTour.m_CheckpointIndices.Remove(actor);
+			m_ShardedActors[checkpointIndex] = nullptr;
+		}
+	}
+
+	if (m_ContentShards.GetShard(m_LearnMoreCheckpointIndex) == Shard)
+	{
+		m_LearnMoreCaptionTimelines.Empty();
+		m_LearnMoreCaptionIds.Empty();
+		m_LearnMoreIds.Empty();
+		m_LearnMoreAssetLists.Empty();
+		m_LearnMoreCheckpointIndex = INDEX_NONE;
+	}
+	if (m_ContentShards.GetShard(m_SessionState.m_CheckpointIndex) == Shard)
+	{
+		m_QuizTileAssetLists.Empty();
+	}
+
+	m_ContentShards.SetResident(Shard, false);
+	m_ContentMemory.Remove(m_ShardedPath + TEXT(":") + m_ContentShards.GetSublevel(Shard).ToString());
+	RequestCaptionSearchRebuild();
+}
+
+void UGameData::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+	if (!Level || World != m_ShardedWorld.Get())
+	{
+		return;
+	}
+	const int32 shard = m_ContentShards.FindShard(FContentShards::GetSublevelName(Level));
+	if (shard == INDEX_NONE || m_ContentShards.IsResident(shard))
+	{
+		return;
+	}
+	const FCheckpointsGameData gameData = LoadCheckpointShard(shard, Level);
+	m_OnContentShardChanged.Broadcast(shard, true, gameData);
+}
+
+//A null level means every sublevel was removed.
+void UGameData::OnLevelRemovedFromWorld(ULevel* Level, UWorld* World)
+{
+	if (World != m_ShardedWorld.Get())
+	{
+		return;
+	}
+	for (int32 shard = 0; shard < m_ContentShards.Num(); shard++)
+	{
+		const bool isRemoved = Level ? m_ContentShards.GetSublevel(shard) == FContentShards::GetSublevelName(Level) : !m_ContentShards.IsPersistent(shard);
+		if (isRemoved && m_ContentShards.IsResident(shard))
+		{
+			UnloadCheckpointShard(shard);
+			m_OnContentShardChanged.Broadcast(shard, false, FCheckpointsGameData());
+		}
+	}
+}
+
 //Read learn more data from a JSON file specified by the given path.
 //It creates a structured representation of the learn more data,
 //including narration sounds, images, captions, and source names.
@@ -121,32 +453,74 @@ FCheckpointsGameData UGameData::LoadCheckpointsData(UWorld* World, FString path,
 //loading and display debug messages if necessary.
 FLearnMoreGameData UGameData::PopulateLearnMoreUI(FString JSONpath, int CurrentActorIndex, TArray<USoundBase*> NarrativeSounds, TArray<UTexture2D*> Images)
 {
-	bool success;
-	FString message;
+	return PopulateLearnMoreUI(FJsonContentFile(JSONpath), CurrentActorIndex, NarrativeSounds, Images);
+}
+
+//Same as PopulateLearnMoreUI for a file a worker step already read.
+FLearnMoreGameData UGameData::PopulateLearnMoreUI(const FJsonContentFile& File, int CurrentActorIndex, const TArray<USoundBase*>& NarrativeSounds, const TArray<UTexture2D*>& Images)
+{
+	m_ReplayRecorder.Record(ETourReplayAction::OpenLearnMore, CurrentActorIndex, INDEX_NONE, File.GetPath());
+	m_LearnMoreCheckpointIndex = CurrentActorIndex;
+
+	return m_LearnMoreLoader.Load(GetLoadEnvironment(), File, CurrentActorIndex, [&](const FLearnMoreData& dataStructure, const FContentLoadContext& context)
+	{
+		FLearnMoreGameData learnMoreGameData;
+		FCaptionTimingData timingData = context.Read<FCaptionTimingData>();
+		m_LearnMoreCaptionTimelines.Empty();
+		m_LearnMoreCaptionIds.Empty();
+		m_LearnMoreIds.Empty();
+		m_LearnMoreAssetLists.Empty();
+		SyncSoundNames(NarrativeSounds);
+		SyncImageNames(Images);
 
-	FLearnMoreGameData learnMoreGameData;
-	FLearnMoreData dataStructure = m_JsonHelper->ReadStructFromJsonFile<FLearnMoreData>(JSONpath, success, message);
-	
-	for (auto data : dataStructure.Data)
-	{
-		if (data.CorrespondingCPIndex == CurrentActorIndex)
-		{
-			FLearnMoreNarration learnMoreNarration;
-			learnMoreNarration.m_FrenchNarrationSounds = GetSoundByName(data.FrenchNarrationSoundNames, NarrativeSounds);
-			learnMoreNarration.m_EnglishNarrationSounds = GetSoundByName(data.EnglishNarrationSoundNames, NarrativeSounds);
-			learnMoreNarration.m_Images = GetImageByName(data.ImagesNames, Images);
-			learnMoreNarration.CorrespondingCPIndex = data.CorrespondingCPIndex;
-			learnMoreNarration.m_TitleKey = data.TitleCaptionKey;
-			learnMoreNarration.m_Keys = data.CaptionKeys;
-			if (!data.ImagesSources.IsEmpty())
+		for (int i = 0; i < dataStructure.Data.Num(); i++)
+		{
+			const auto& data = dataStructure.Data[i];
+			if (data.CorrespondingCPIndex == CurrentActorIndex)
 			{
-				learnMoreNarration.m_SourceName = data.ImagesSources[0];
+				FLearnMoreNarration learnMoreNarration;
+				learnMoreNarration.m_FrenchNarrationSounds = FindSounds(data.FrenchNarrationSoundNames);
+				learnMoreNarration.m_EnglishNarrationSounds = FindSounds(data.EnglishNarrationSoundNames);
+				learnMoreNarration.m_Images = FindImages(data.ImagesNames);
+				learnMoreNarration.CorrespondingCPIndex = data.CorrespondingCPIndex;
+				learnMoreNarration.m_TitleKey = data.TitleCaptionKey;
+				learnMoreNarration.m_Keys = data.CaptionKeys;
+				if (!data.ImagesSources.IsEmpty())
+				{
+					learnMoreNarration.m_SourceName = data.ImagesSources[0];
+				}
+				learnMoreGameData.LearnMoreData.Add(learnMoreNarration);
+				m_LearnMoreCaptionTimelines.Add(BuildCaptionTimelines(timingData, i, learnMoreNarration.m_Keys.Num(),
+					learnMoreNarration.m_EnglishNarrationSounds, learnMoreNarration.m_FrenchNarrationSounds));
+				m_LearnMoreCaptionIds.Add(RegisterCaptionIds(learnMoreNarration.m_TitleKey, learnMoreNarration.m_Keys));
+				m_LearnMoreIds.Add(i);
+				m_LearnMoreAssetLists.Add(InternAssetLists(learnMoreNarration.m_EnglishNarrationSounds, learnMoreNarration.m_FrenchNarrationSounds, learnMoreNarration.m_Images));
 			}
-			learnMoreGameData.LearnMoreData.Add(learnMoreNarration);
 		}
-	}
 
-	return learnMoreGameData;
+		//Every entry of the file is searchable, not only the panel on
+		//screen. The learn more index of an entry is its index in the
+		//panel of its checkpoint.
+		if (m_LearnMoreSearchPath != File.GetPath() || m_LearnMoreSearchHash != File.GetContentHash())
+		{
+			m_LearnMoreSearchPath = File.GetPath();
+			m_LearnMoreSearchHash = File.GetContentHash();
+			m_LearnMoreSearchEntries.Empty(dataStructure.Data.Num());
+			TMap<int32, int32> numEntries;
+			for (const auto& data : dataStructure.Data)
+			{
+				FLearnMoreSearchEntry& entry = m_LearnMoreSearchEntries.AddDefaulted_GetRef();
+				entry.m_Hit.m_Source = ECaptionSearchSource::LearnMore;
+				entry.m_Hit.m_CheckpointIndex = data.CorrespondingCPIndex;
+				entry.m_Hit.m_LearnMoreIndex = numEntries.FindOrAdd(data.CorrespondingCPIndex)++;
+				entry.m_CaptionIds = RegisterCaptionIds(data.TitleCaptionKey, data.CaptionKeys);
+			}
+			m_LearnMoreSearchEntries.StableSort([](const FLearnMoreSearchEntry& A, const FLearnMoreSearchEntry& B) { return A.m_Hit.m_CheckpointIndex < B.m_Hit.m_CheckpointIndex; });
+		}
+		m_CaptionTexts.Resolve();
+		RequestCaptionSearchRebuild();
+		return learnMoreGameData;
+	});
 }
 
 //Dynamically creates UProgressBar instances, configures their
@@ -156,7 +530,9 @@ FLearnMoreGameData UGameData::PopulateLearnMoreUI(FString JSONpath, int CurrentA
 //Learn More content.
 TArray<UProgressBar*> UGameData::LoadLearnMoreProgressBar(UHorizontalBox* progressBarsBox, FProgressBarStyle progressBarStyle, int numberOfLearnMoreOptions) const
 {
+	FGameDataLatencyScope latencyScope(TEXT("LoadLearnMoreProgressBar"), m_SessionState, m_SessionState.m_CheckpointIndex);
 	TArray<UProgressBar*> learnMoreProgressBars;
+	m_CreatedProgressBars.RemoveAll([](const TWeakObjectPtr<UProgressBar>& progressBar) { return !progressBar.IsValid(); });
 	for (size_t i = 0; i < numberOfLearnMoreOptions; i++)
 	{
 		if (UProgressBar* progressBar = NewObject<UProgressBar>())
@@ -170,134 +546,815 @@ TArray<UProgressBar*> UGameData::LoadLearnMoreProgressBar(UHorizontalBox* progre
 			progressBar->SetBarFillStyle(EProgressBarFillStyle::Mask);
 			progressBar->SetWidgetStyle(progressBarStyle);
 			learnMoreProgressBars.Add(progressBar);
+			m_CreatedProgressBars.Add(progressBar);
 		}
 	}
 	return learnMoreProgressBars;
 }
 
-//-----------------------------------\\
-//--                               --\\
-//--        RADAR GAME DATA        --\\
-//--                               --\\
-//-----------------------------------\\
-
-//Read and loading quiz questions from a JSON file.
-//It utilizes the m_JsonHelper to deserialize the
-//JSON data into the FQuizQuestions structure.
-//In case of any issues, it displays an on-screen debug message.
-//The method ultimately returns the loaded quiz data.
-FQuizQuestions UGameData::LoadQuizQuestions() const
+//Loads the content of the next part of the tour without blocking the game
+//thread: the JSON files are read and parsed on a worker thread, then the
+//checkpoints, learn more entries, progress bars and quiz tiles are built on
+//the game thread, one step per frame, and the learn more images are primed.
+//The game thread steps load from the files the worker read, so they do not
+//read or hash them again.
+//The returned pipeline can be cancelled when the visitor leaves the tour.
+TSharedRef<FGameDataPipeline> UGameData::LoadTourSegmentAsync(UWorld* World, const FTourSegmentRequest& Request, TUniqueFunction<void(bool, const FTourSegment&)>&& OnLoaded)
 {
-	bool success;
-	FString message;
+	TSharedRef<FGameDataPipeline> pipeline = FGameDataPipeline::Create();
+	TSharedRef<FTourSegment> segment = MakeShared<FTourSegment>();
+	TWeakObjectPtr<UGameData> weakThis(this);
+	TWeakObjectPtr<UWorld> weakWorld(World);
+	TWeakPtr<FGameDataPipeline> weakPipeline(pipeline);
 
-	const FString FilePath = FPaths::ProjectContentDir() + "/JSONFiles/AutomatedTour/quiz.json";
-	FQuizQuestions quizData = m_JsonHelper->ReadStructFromJsonFile<FQuizQuestions>(FilePath, success, message);
+	//Cancels the pipeline when UGameData went away between two steps.
+	const auto getThis = [weakThis, weakPipeline]() -> UGameData*
+	{
+		if (!weakThis.IsValid() && weakPipeline.IsValid())
+		{
+			weakPipeline.Pin()->Cancel();
+		}
+		return weakThis.Get();
+	};
 
-	if (!success)
+	//UGameData is kept alive while the worker step uses its parse cache,
+	//and released on the game thread once the worker step is done.
+	TSharedRef<TStrongObjectPtr<UGameData>> keepAlive = MakeShared<TStrongObjectPtr<UGameData>>(this);
+	TSharedRef<TOptional<FJsonContentFile>> checkpointsFile = MakeShared<TOptional<FJsonContentFile>>();
+	TSharedRef<TOptional<FJsonContentFile>> learnMoreFile = MakeShared<TOptional<FJsonContentFile>>();
+	TSharedRef<TOptional<FJsonContentFile>> quizFile = MakeShared<TOptional<FJsonContentFile>>();
+
+	pipeline->OnWorker([parseCache = &m_ParseCache, jsonHelper = m_JsonHelper, Request, checkpointsFile, learnMoreFile, quizFile]()
 	{
-		if (GEngine) GEngine->AddOnScreenDebugMessage(-1, 60.0f, FColor::Green, message);
-	}
+		//The files of the segment are read together, then each struct
+		//is read from the batch.
+		TArray<FString> paths;
+		for (const FString& path : { Request.m_CheckpointsPath, Request.m_LearnMorePath, Request.m_QuizPath })
+		{
+			if (!path.IsEmpty())
+			{
+				paths.Add(path);
+			}
+		}
+		const FContentFileBatch batch(paths);
 
-	return quizData;
+		//The structs of a file share one read and hash of its content.
+		if (!Request.m_CheckpointsPath.IsEmpty())
+		{
+			const FJsonContentFile& file = checkpointsFile->Emplace(Request.m_CheckpointsPath, &batch);
+			parseCache->Prefetch<FCheckpointsData>(jsonHelper, file);
+			parseCache->Prefetch<FCaptionTimingData>(jsonHelper, file);
+			parseCache->Prefetch<FTourGraphData>(jsonHelper, file);
+		}
+		if (!Request.m_LearnMorePath.IsEmpty())
+		{
+			const FJsonContentFile& file = learnMoreFile->Emplace(Request.m_LearnMorePath, &batch);
+			parseCache->Prefetch<FLearnMoreData>(jsonHelper, file);
+			parseCache->Prefetch<FCaptionTimingData>(jsonHelper, file);
+		}
+		if (!Request.m_QuizPath.IsEmpty())
+		{
+			parseCache->Prefetch<FQuizQuestions>(jsonHelper, quizFile->Emplace(Request.m_QuizPath, &batch));
+		}
+	})
+	.OnGameThread([getThis, weakWorld, segment, keepAlive, Request, checkpointsFile]()
+	{
+		keepAlive->Reset();
+		if (UGameData* gameData = getThis())
+		{
+			if (checkpointsFile->IsSet())
+			{
+				segment->m_Checkpoints = gameData->LoadCheckpointsData(weakWorld.Get(), checkpointsFile->GetValue(), Request.m_NarrativeSounds, Request.m_CPActors);
+			}
+		}
+	})
+	.NextFrame()
+	.OnGameThread([getThis, segment, Request, learnMoreFile]()
+	{
+		if (UGameData* gameData = getThis())
+		{
+			if (learnMoreFile->IsSet())
+			{
+				segment->m_LearnMore = gameData->PopulateLearnMoreUI(learnMoreFile->GetValue(), Request.m_CheckpointIndex, Request.m_NarrativeSounds, Request.m_Images);
+			}
+			if (Request.m_ProgressBarsBox)
+			{
+				segment->m_ProgressBars = gameData->LoadLearnMoreProgressBar(Request.m_ProgressBarsBox, Request.m_ProgressBarStyle, segment->m_LearnMore.LearnMoreData.Num());
+			}
+		}
+	})
+	.NextFrame()
+	.OnGameThread([getThis, segment, Request, quizFile]()
+	{
+		UGameData* gameData = getThis();
+		if (!gameData || !quizFile->IsSet() || !gameData->m_ActiveTour.m_Flags.Has(Request.m_CheckpointIndex, ECheckpointFlag::HasQuiz))
+		{
+			return;
+		}
+
+		segment->m_QuizQuestions = gameData->m_QuizQuestionsLoader.Load(gameData->GetLoadEnvironment(), quizFile->GetValue(), Request.m_CheckpointIndex,
+			[](const FQuizQuestions& quizData, const FContentLoadContext& context) { return quizData; });
+		if (segment->m_QuizQuestions.m_Questions.Num() > 0)
+		{
+			segment->m_QuizTiles = gameData->PopulateQuizUI(Request.m_NarrativeSounds, segment->m_QuizQuestions, 0);
+		}
+	})
+	.NextFrame()
+	.OnGameThread([segment]()
+	{
+		//Streams in the full mips of the images the visitor is about to see.
+		for (const FLearnMoreNarration& narration : segment->m_LearnMore.LearnMoreData)
+		{
+			for (UTexture2D* image : narration.m_Images)
+			{
+				if (image)
+				{
+					image->SetForceMipLevelsToBeResident(30.0f);
+				}
+			}
+		}
+	})
+	.Start([segment, keepAlive, OnLoaded = MoveTemp(OnLoaded)](bool bCompleted)
+	{
+		keepAlive->Reset();
+		if (OnLoaded)
+		{
+			OnLoaded(bCompleted, *segment);
+		}
+	});
+
+	return pipeline;
 }
 
-//Populates data for the quiz user interface. It takes
-//information from the provided FQuizQuestions structure,
-//extracts options for the current quiz question, and
-//organizes them into a format suitable for the quiz UI.
-//This method builds a mapping of quiz options to their
-//respective narrations and sound cues, encapsulating the data needed.
-FTilesGameData UGameData::PopulateQuizUI(TArray<USoundBase*> NarrativeSounds, const FQuizQuestions& QuizQuestions, int32 CurrentQuestionIndex)
+//Prepares another tour in the staging slot while the active one keeps
+//running: the files are parsed on a worker thread, the graph is built and
+//the checkpoints are built a few at a time within a frame budget, then the
+//narrations are precached. Nothing of the active tour is touched, so the
+//controller calls SwapStagedTour at a safe point once it is prepared.
+//Preparing another tour cancels the one being prepared, and a tour whose
+//files could not be read is not staged.
+TSharedRef<FGameDataPipeline> UGameData::PrepareTourAsync(UWorld* World, FString path, TArray<USoundBase*> NarrativeSounds, TArray<AActor*> CPActors, TUniqueFunction<void(bool)>&& OnPrepared)
 {
-	FTilesGameData tilesData;
-	TArray<FQuizQuestionOption> options = QuizQuestions.m_Questions[CurrentQuestionIndex].QuestionOptions.Options;
-	TMap<int, FLearnMoreNarration> narrationMap;
-	FLearnMoreNarration narration;
+	static constexpr double FrameBudget = 0.002;
 
-	for (int i = 0; i < options.Max(); i++)
+	if (TSharedPtr<FGameDataPipeline> previousPipeline = m_StagingPipeline.Pin())
 	{
-		narration.m_TitleKey = options[i].OptionName;
-		narration.m_Keys.Add(options[i].OptionDescription);
-
-		TArray<FString> sounds;
-		sounds.Add(QuizQuestions.m_Questions[CurrentQuestionIndex].QuestionOptions.Options[i].EnglishNarrationSound);
-		narration.m_EnglishNarrationSounds = GetSoundByName(sounds, NarrativeSounds);
-		sounds.Empty();
-		sounds.Add(QuizQuestions.m_Questions[CurrentQuestionIndex].QuestionOptions.Options[i].FrenchNarrationSound);
-		narration.m_FrenchNarrationSounds = GetSoundByName(sounds, NarrativeSounds);
-		narrationMap.Add(i, narration);
+		previousPipeline->Cancel();
 	}
+	const int32 generation = ++m_StagingGeneration;
+	m_IsTourStaged = false;
+	m_StagingTour = FTourState();
 
-	tilesData.LearnMoreKeyMap = narrationMap;
-	return tilesData;
-}
-
-//-----------------------------------\\
-//--                               --\\
-//--            GETTERS            --\\
-//--                               --\\
-//-----------------------------------\\
+	TSharedRef<FGameDataPipeline> pipeline = FGameDataPipeline::Create();
+	m_StagingPipeline = pipeline;
+	TSharedRef<FCheckpointsData> source = MakeShared<FCheckpointsData>();
+	TSharedRef<FCaptionTimingData> timingData = MakeShared<FCaptionTimingData>();
+	TSharedRef<FContentDiagnostics> diagnostics = MakeShared<FContentDiagnostics>();
+	TSharedRef<TOptional<FJsonContentFile>> file = MakeShared<TOptional<FJsonContentFile>>();
+	TSharedRef<int32> nextCheckpoint = MakeShared<int32>(0);
+	TWeakObjectPtr<UGameData> weakThis(this);
+	TWeakObjectPtr<UWorld> weakWorld(World);
+	TWeakPtr<FGameDataPipeline> weakPipeline(pipeline);
+	TSharedRef<TStrongObjectPtr<UGameData>> keepAlive = MakeShared<TStrongObjectPtr<UGameData>>(this);
 
-//Designed to retrieve an actor with a specific name from
-//a provided array of actors (CPActors). The method also
-//sets a success flag and provides an information message
-//to indicate whether the actor was successfully located or not.
-AActor* UGameData::GetActorByName(const FString& ActorName, TArray<AActor*> CPActors, UWorld* World, bool& success, FString& infoMessage)
-{
-	for (AActor* cp : CPActors)
+	//Returns UGameData while this pipeline is the one preparing the staging
+	//tour, and cancels the pipeline otherwise.
+	const auto getThis = [weakThis, weakPipeline, generation]() -> UGameData*
 	{
-		if (cp && cp->Tags[0] == FName(ActorName))
+		UGameData* gameData = weakThis.Get();
+		if (!gameData || gameData->m_StagingGeneration != generation)
 		{
-			success = true;
-			infoMessage = FString("Actor Found");
-			return cp;
+			if (TSharedPtr<FGameDataPipeline> stagingPipeline = weakPipeline.Pin())
+			{
+				stagingPipeline->Cancel();
+			}
+			return nullptr;
 		}
-	}
-	success = false;
-	infoMessage = FString("Actor Not Found");;
-	return nullptr;
-}
+		return gameData;
+	};
 
-//Designed to retrieve an array of sound assets based on a
-//provided array of sound names (SoundNames) and an existing
-//array of sound assets (NarrativeSounds)
-TArray<USoundBase*> UGameData::GetSoundByName(const TArray<FString> SoundNames, TArray<USoundBase*> NarrativeSounds)
-{
-	TArray<USoundBase*> sounds;
-	for (FString soundName : SoundNames)
+	pipeline->OnWorker([parseCache = &m_ParseCache, jsonHelper = m_JsonHelper, file, path]()
+	{
+		const FContentFileBatch batch({ path });
+		file->Emplace(path, &batch);
+		parseCache->Prefetch<FCheckpointsData>(jsonHelper, file->GetValue());
+		parseCache->Prefetch<FCaptionTimingData>(jsonHelper, file->GetValue());
+		parseCache->Prefetch<FTourGraphData>(jsonHelper, file->GetValue());
+	})
+	.OnGameThread([getThis, weakPipeline, keepAlive, source, timingData, file, path]()
 	{
-		for (USoundBase* Sound : NarrativeSounds)
+		keepAlive->Reset();
+		UGameData* gameData = getThis();
+		if (!gameData || !file->IsSet())
+		{
+			return;
+		}
+
+		//The staged tour is measured once it is swapped in.
+		FContentLoadEnvironment environment = gameData->GetLoadEnvironment();
+		environment.m_ContentMemory = nullptr;
+		FTourState& tour = gameData->m_StagingTour;
+		const bool isLoaded = gameData->m_StagedTourLoader.Load(environment, file->GetValue(), INDEX_NONE, [&](const FCheckpointsData& checkpointsData, const FContentLoadContext& context)
+		{
+			*source = checkpointsData;
+			*timingData = context.Read<FCaptionTimingData>();
+			FTourGraphData graphData = context.Read<FTourGraphData>();
+			TArray<int32> frameNumbers;
+			for (const auto& data : source->Data)
+			{
+				frameNumbers.Add(data.CheckpointFrameNumber);
+			}
+			FString message;
+			context.Check(tour.m_Graph.Build(graphData, frameNumbers, message), message);
+			tour.m_FrameNumbers = MoveTemp(frameNumbers);
+			return !context.HasProblems();
+		});
+		if (!isLoaded)
 		{
-			if (Sound && Sound->GetName() == soundName && !sounds.Contains(Sound))
+			tour = FTourState();
+			if (TSharedPtr<FGameDataPipeline> stagingPipeline = weakPipeline.Pin())
 			{
-				sounds.Add(Sound);
+				stagingPipeline->Cancel();
 			}
+			return;
+		}
+		tour.m_Path = path;
+		tour.m_TourKey = FCrc::StrCrc32(*path, source->Data.Num());
+		tour.m_Flags.Reset(source->Data.Num());
+	})
+	.OnEachFrame([getThis, weakWorld, source, timingData, diagnostics, nextCheckpoint, NarrativeSounds, CPActors]()
+	{
+		UGameData* gameData = getThis();
+		if (!gameData)
+		{
+			return true;
 		}
-	}
-	return sounds;
-}
 
-//Designed to retrieve an array of images assets based on a
-//provided array of images names (ImageNames) and an existing
-//array of images assets (Images)
-TArray<UTexture2D*> UGameData::GetImageByName(const TArray<FString> ImageNames, TArray<UTexture2D*> Images)
-{
-	TArray<UTexture2D*> foundImages;
+		LLM_SCOPE_BYTAG(GameData);
+		FTourState& tour = gameData->m_StagingTour;
+		gameData->SyncSoundNames(NarrativeSounds);
+		const double startTime = FPlatformTime::Seconds();
+		while (*nextCheckpoint < source->Data.Num() && FPlatformTime::Seconds() - startTime < FrameBudget)
+		{
+			const int i = (*nextCheckpoint)++;
+			bool success;
+			FString message;
+			AActor* actor = gameData->GetCheckpointActor(source->Data[i].CheckpointName, CPActors, weakWorld.Get(), success, message);
+			if (!success)
+			{
+				diagnostics->Add(message);
+			}
 
-	for (FString imageName : ImageNames)
+			tour.m_Checkpoints.ActorsToFollow.Add(actor);
+			tour.m_Checkpoints.ActorFrameMap.Add(actor, source->Data[i].CheckpointFrameNumber);
+			FNarrationKeys narrationKeys = gameData->LoadCheckpointNarration(tour, *source, *timingData, i, actor);
+			tour.m_Flags.Set(i, ECheckpointFlag::ShouldStopCamera, narrationKeys.m_ShouldStopCamera);
+			tour.m_Flags.Set(i, ECheckpointFlag::HasLearnMoreOption, narrationKeys.m_HasLearnMoreOption);
+			tour.m_Flags.Set(i, ECheckpointFlag::HasQuiz, narrationKeys.m_HasQuiz);
+			StripAssetLists(narrationKeys);
+			tour.m_Checkpoints.ActorKeyMap.Add(actor, narrationKeys);
+		}
+		return *nextCheckpoint >= source->Data.Num();
+	})
+	.NextFrame()
+	.OnGameThread([getThis, diagnostics, path]()
+	{
+		if (UGameData* gameData = getThis())
+		{
+			diagnostics->Report(TEXT("PrepareTourAsync"), path);
+			gameData->m_CaptionTexts.Resolve();
+		}
+	})
+	.NextFrame()
+	.OnGameThread([getThis]()
 	{
-		for (UTexture2D* Image : Images)
+		//Decompresses the narrations ahead, so the first checkpoint of the
+		//new tour does not wait on audio.
+		UGameData* gameData = getThis();
+		FAudioDevice* audioDevice = GEngine ? GEngine->GetMainAudioDeviceRaw() : nullptr;
+		if (!gameData || !audioDevice)
+		{
+			return;
+		}
+		for (const auto& assetLists : gameData->m_StagingTour.m_AssetLists)
 		{
-			if (Image && Image->GetName() == imageName && !foundImages.Contains(Image))
+			for (FAssetListHandle handle : { assetLists.Value.m_EnglishSounds, assetLists.Value.m_FrenchSounds })
 			{
-				foundImages.Add(Image);
+				for (USoundBase* sound : gameData->m_SoundListPool.Get(handle))
+				{
+					if (USoundWave* soundWave = Cast<USoundWave>(sound))
+					{
+						audioDevice->Precache(soundWave, false, true, false);
+					}
+				}
 			}
 		}
-	}
+	})
+	.Start([weakThis, keepAlive, generation, OnPrepared = MoveTemp(OnPrepared)](bool bCompleted)
+	{
+		keepAlive->Reset();
+		UGameData* gameData = weakThis.Get();
+		if (gameData && gameData->m_StagingGeneration == generation)
+		{
+			gameData->m_IsTourStaged = bCompleted;
+		}
+		if (OnPrepared)
+		{
+			OnPrepared(bCompleted);
+		}
+	});
+
+	return pipeline;
+}
+
+//Makes the prepared tour the active one. The swap only exchanges the two
+//tour states, and the previous tour is freed on a worker thread, so the
+//frame of the swap costs no more than any other. Returns the checkpoint
+//data of the new tour, like LoadCheckpointsData, its sounds expanded from
+//the asset list pool the staged narrations kept them in.
+FCheckpointsGameData UGameData::SwapStagedTour()
+{
+	if (!m_IsTourStaged)
+	{
+		return FCheckpointsGameData();
+	}
+
+	m_ReplayRecorder.Record(ETourReplayAction::LoadCheckpoints, INDEX_NONE, INDEX_NONE, m_StagingTour.m_Path);
+	Swap(m_ActiveTour, m_StagingTour);
+	m_IsTourStaged = false;
+	ResetShardedTour();
+	if (m_SessionState.m_TourKey != m_ActiveTour.m_TourKey)
+	{
+		m_SessionState.Reset(m_ActiveTour.m_TourKey);
+	}
+
+	FCheckpointsGameData gameData = MoveTemp(m_ActiveTour.m_Checkpoints);
+	for (auto& narration : gameData.ActorKeyMap)
+	{
+		if (const FNarrationAssetLists* assetLists = m_ActiveTour.m_AssetLists.Find(narration.Key))
+		{
+			narration.Value.m_EnglishNarrationSounds = m_SoundListPool.Get(assetLists->m_EnglishSounds);
+			narration.Value.m_FrenchNarrationSounds = m_SoundListPool.Get(assetLists->m_FrenchSounds);
+		}
+	}
+	m_ContentMemory.Remove(m_StagingTour.m_Path);
+	m_ContentMemory.FindOrAdd(m_ActiveTour.m_Path) = FGameDataMemoryReport();
+	m_ContentMemory[m_ActiveTour.m_Path].Measure(gameData);
+
+	Async(EAsyncExecution::ThreadPool, [previousTour = MoveTemp(m_StagingTour)]() {});
+	m_StagingTour = FTourState();
+	CompactAssetLists();
+	RequestCaptionSearchRebuild();
+	return gameData;
+}
+
+//Reads the learn more file of a checkpoint ahead of PopulateLearnMoreUI
+//through the content request scheduler. The deadline is when the camera
+//reaches the checkpoint, from the frame distance to the current checkpoint.
+//Requests for the checkpoint already reached have no deadline to miss, and
+//are ordered by their priority only.
+FContentRequestToken UGameData::RequestLearnMoreContent(const FString& JSONpath, int32 CheckpointIndex, EContentRequestPriority Priority, TUniqueFunction<void()>&& OnReady)
+{
+	double deadline = 0.0;
+	const int32 currentCheckpoint = m_SessionState.m_CheckpointIndex;
+	if (m_ActiveTour.m_FrameNumbers.IsValidIndex(CheckpointIndex) && m_ActiveTour.m_FrameNumbers.IsValidIndex(currentCheckpoint))
+	{
+		const int32 frames = m_ActiveTour.m_FrameNumbers[CheckpointIndex] - m_ActiveTour.m_FrameNumbers[currentCheckpoint];
+		if (frames > 0)
+		{
+			deadline = FPlatformTime::Seconds() + frames / FMath::Max(CVarGameDataCameraFrameRate.GetValueOnGameThread(), 1.0f);
+		}
+	}
+
+	return m_ContentRequests.Request(FName(*JSONpath), Priority, deadline, CheckpointIndex, [parseCache = &m_ParseCache, jsonHelper = m_JsonHelper, JSONpath]()
+	{
+		const FContentFileBatch batch({ JSONpath });
+		const FJsonContentFile file(JSONpath, &batch);
+		parseCache->Prefetch<FLearnMoreData>(jsonHelper, file);
+		parseCache->Prefetch<FCaptionTimingData>(jsonHelper, file);
+	}, MoveTemp(OnReady));
+}
+
+//-----------------------------------\\
+//--                               --\\
+//--        RADAR GAME DATA        --\\
+//--                               --\\
+//-----------------------------------\\
+
+//Read and loading quiz questions from a JSON file.
+//It utilizes the m_JsonHelper to deserialize the
+//JSON data into the FQuizQuestions structure.
+//In case of any issues, it displays an on-screen debug message.
+//The method ultimately returns the loaded quiz data.
+FQuizQuestions UGameData::LoadQuizQuestions() const
+{
+	const FString FilePath = FPaths::ProjectContentDir() + "/JSONFiles/AutomatedTour/quiz.json";
+	m_ReplayRecorder.Record(ETourReplayAction::LoadQuizQuestions);
+	return m_QuizQuestionsLoader.Load(GetLoadEnvironment(), FilePath, INDEX_NONE, [](const FQuizQuestions& quizData, const FContentLoadContext& context)
+	{
+		return quizData;
+	});
+}
+
+//Returns what the content loaders share with UGameData.
+FContentLoadEnvironment UGameData::GetLoadEnvironment() const
+{
+	FContentLoadEnvironment environment;
+	environment.m_ParseCache = &m_ParseCache;
+	environment.m_JsonHelper = m_JsonHelper;
+	environment.m_SessionState = &m_SessionState;
+	environment.m_ContentMemory = &m_ContentMemory;
+	return environment;
+}
+
+//Opens a paged question bank from its index file. Only the index
+//is read here; the pages are read when questions are sampled.
+//In case of any issues, it displays an on-screen debug message.
+bool UGameData::OpenQuizQuestionBank(const FString& IndexPath)
+{
+	FGameDataLatencyScope latencyScope(TEXT("OpenQuizQuestionBank"), m_SessionState);
+	m_ReplayRecorder.Record(ETourReplayAction::OpenQuizBank, INDEX_NONE, INDEX_NONE, IndexPath);
+	FString message;
+	const bool success = m_QuizQuestionBank.Open(m_JsonHelper, IndexPath, message);
+
+	if (!success)
+	{
+		if (GEngine) GEngine->AddOnScreenDebugMessage(-1, 60.0f, FColor::Green, message);
+	}
+
+	return success;
+}
+
+//Samples questions at random from the opened question bank, optionally
+//only the ones of a checkpoint, and loads them with their options from
+//the pages they live in. The result is indexed like LoadQuizQuestions
+//so it can be given to PopulateQuizUI.
+FQuizQuestions UGameData::LoadQuizQuestionsSample(int32 NumQuestions, FRandomStream& RandomStream, int32 CorrespondingCPIndex)
+{
+	FGameDataLatencyScope latencyScope(TEXT("LoadQuizQuestionsSample"), m_SessionState, CorrespondingCPIndex);
+	m_ReplayRecorder.Record(ETourReplayAction::LoadQuizSample, NumQuestions, CorrespondingCPIndex, FString(), RandomStream.GetCurrentSeed());
+	bool success;
+	FString message;
+
+	const TArray<FQuizQuestionRef> questionRefs = m_QuizQuestionBank.SampleQuestions(NumQuestions, RandomStream, CorrespondingCPIndex);
+	FQuizQuestions quizData = m_QuizQuestionBank.LoadQuestions(questionRefs, success, message);
+
+	if (!success)
+	{
+		if (GEngine) GEngine->AddOnScreenDebugMessage(-1, 60.0f, FColor::Green, message);
+	}
+
+	return quizData;
+}
+
+//Populates data for the quiz user interface. It takes
+//information from the provided FQuizQuestions structure,
+//extracts options for the current quiz question, and
+//organizes them into a format suitable for the quiz UI.
+//This method builds a mapping of quiz options to their
+//respective narrations and sound cues, encapsulating the data needed.
+//The question shown is remembered for the answer statistics.
+FTilesGameData UGameData::PopulateQuizUI(TArray<USoundBase*> NarrativeSounds, const FQuizQuestions& QuizQuestions, int32 CurrentQuestionIndex)
+{
+	FGameDataLatencyScope latencyScope(TEXT("PopulateQuizUI"), m_SessionState, m_SessionState.m_CheckpointIndex);
+	LLM_SCOPE_BYTAG(GameData);
+	m_ReplayRecorder.Record(ETourReplayAction::ShowQuizQuestion, CurrentQuestionIndex);
+	FTilesGameData tilesData;
+	TArray<FQuizQuestionOption> options = QuizQuestions.m_Questions[CurrentQuestionIndex].QuestionOptions.Options;
+	TMap<int, FLearnMoreNarration> narrationMap;
+	FLearnMoreNarration narration;
+	TArray<FString> optionNames;
+	m_QuizTileAssetLists.Empty();
+	SyncSoundNames(NarrativeSounds);
+
+	for (int i = 0; i < options.Max(); i++)
+	{
+		optionNames.Add(options[i].OptionName);
+		narration.m_TitleKey = options[i].OptionName;
+		narration.m_Keys.Add(options[i].OptionDescription);
+
+		TArray<FString> sounds;
+		sounds.Add(QuizQuestions.m_Questions[CurrentQuestionIndex].QuestionOptions.Options[i].EnglishNarrationSound);
+		narration.m_EnglishNarrationSounds = FindSounds(sounds);
+		sounds.Empty();
+		sounds.Add(QuizQuestions.m_Questions[CurrentQuestionIndex].QuestionOptions.Options[i].FrenchNarrationSound);
+		narration.m_FrenchNarrationSounds = FindSounds(sounds);
+		narrationMap.Add(i, narration);
+		m_QuizTileAssetLists.Add(InternAssetLists(narration.m_EnglishNarrationSounds, narration.m_FrenchNarrationSounds));
+	}
+
+	tilesData.LearnMoreKeyMap = narrationMap;
+	m_CurrentQuizQuestionKey = FQuizAnalytics::MakeQuestionKey(optionNames);
+	m_ContentMemory.FindOrAdd(TEXT("Quiz Tiles")) = FGameDataMemoryReport();
+	m_ContentMemory[TEXT("Quiz Tiles")].Measure(tilesData);
+	return tilesData;
+}
+
+//Records the option selected by the visitor for the question last
+//populated by PopulateQuizUI. Safe to call from any thread; the
+//statistics are written to disk in the background.
+void UGameData::RecordQuizAnswer(int32 SelectedOptionIndex) const
+{
+	FGameDataLatencyScope latencyScope(TEXT("RecordQuizAnswer"), m_SessionState, m_SessionState.m_CheckpointIndex);
+	FQuizAnalytics::Get().RecordAnswer(m_CurrentQuizQuestionKey, SelectedOptionIndex);
+}
+
+//-----------------------------------\\
+//--                               --\\
+//--         SESSION STATE         --\\
+//--                               --\\
+//-----------------------------------\\
+
+//Records the checkpoint the visitor just reached and snapshots the
+//session progress on disk in the background, so the tour can resume
+//from this checkpoint if the kiosk crashes or is reset. Pending content
+//reads for checkpoints behind the visitor are cancelled.
+void UGameData::MarkCheckpointReached(int32 CheckpointIndex)
+{
+	FGameDataLatencyScope latencyScope(TEXT("MarkCheckpointReached"), m_SessionState, CheckpointIndex);
+	m_ReplayRecorder.Record(ETourReplayAction::CheckpointReached, CheckpointIndex);
+	m_SessionState.m_CheckpointIndex = CheckpointIndex;
+	m_SessionStore.SaveAsync(m_SessionState);
+
+	//Reads for checkpoints the visitor can no longer reach are dropped.
+	m_ContentRequests.CancelIf([this, CheckpointIndex](int32 Tag)
+	{
+		return Tag != INDEX_NONE && Tag != CheckpointIndex && !m_ActiveTour.m_Graph.CanReach(CheckpointIndex, Tag);
+	});
+}
+
+//Records a learn more entry as completed, using the same index as the
+//LearnMoreData returned by PopulateLearnMoreUI. The entry is stored by its
+//position in the learn more JSON file, which does not depend on the checkpoint.
+void UGameData::MarkLearnMoreCompleted(int LearnMoreIndex)
+{
+	m_ReplayRecorder.Record(ETourReplayAction::CompleteLearnMore, LearnMoreIndex);
+	if (!m_LearnMoreIds.IsValidIndex(LearnMoreIndex))
+	{
+		return;
+	}
+	const int32 learnMoreId = m_LearnMoreIds[LearnMoreIndex];
+	while (m_SessionState.m_CompletedLearnMore.Num() <= learnMoreId)
+	{
+		m_SessionState.m_CompletedLearnMore.Add(false);
+	}
+	m_SessionState.m_CompletedLearnMore[learnMoreId] = true;
+}
+
+//Records the option selected for a quiz question.
+void UGameData::MarkQuizAnswered(int32 QuestionIndex, int32 SelectedOptionIndex)
+{
+	m_ReplayRecorder.Record(ETourReplayAction::AnswerQuiz, QuestionIndex, SelectedOptionIndex);
+	if (QuestionIndex < 0)
+	{
+		return;
+	}
+	m_SessionState.m_QuizQuestionIndex = QuestionIndex;
+	while (m_SessionState.m_QuizAnswers.Num() <= QuestionIndex)
+	{
+		m_SessionState.m_QuizAnswers.Add(INDEX_NONE);
+	}
+	m_SessionState.m_QuizAnswers[QuestionIndex] = (int8)SelectedOptionIndex;
+}
+
+bool UGameData::IsLearnMoreCompleted(int LearnMoreIndex) const
+{
+	if (!m_LearnMoreIds.IsValidIndex(LearnMoreIndex))
+	{
+		return false;
+	}
+	const int32 learnMoreId = m_LearnMoreIds[LearnMoreIndex];
+	return learnMoreId < m_SessionState.m_CompletedLearnMore.Num() && m_SessionState.m_CompletedLearnMore[learnMoreId];
+}
+
+//Restores the progress saved by a previous run. It must be called after
+//LoadCheckpointsData, since a record of another tour is ignored.
+//In case of any issues, it displays an on-screen debug message.
+bool UGameData::RestoreSessionState()
+{
+	FGameDataLatencyScope latencyScope(TEXT("RestoreSessionState"), m_SessionState);
+	FString message;
+	FVisitorSessionState restoredState;
+	bool success = m_SessionStore.Restore(restoredState, message);
+
+	if (success && restoredState.m_TourKey != m_SessionState.m_TourKey)
+	{
+		success = false;
+		message = FString("Session Of Another Tour");
+	}
+
+	if (!success)
+	{
+		if (GEngine) GEngine->AddOnScreenDebugMessage(-1, 60.0f, FColor::Green, message);
+		return false;
+	}
+
+	m_SessionState = MoveTemp(restoredState);
+	return true;
+}
+
+//Points the parse cache and the session record to files under the given
+//directory, and empties that parse cache. Used by the tour replay, so its
+//runs start with a cold parse cache and leave the kiosk files alone.
+void UGameData::UseScratchDir(const FString& Dir)
+{
+	m_ParseCache.SetCacheDir(Dir / TEXT("GameDataCache"));
+	m_ParseCache.Clear();
+	m_SessionStore.SetFilePath(Dir / TEXT("Session") / TEXT("VisitorSession.bin"));
+}
+
+//Forgets the progress once the visitor completed the tour.
+//When a tour replay is recorded, the script is written at this point.
+void UGameData::ClearSessionState()
+{
+	m_SessionState.Reset(m_SessionState.m_TourKey);
+	m_SessionStore.Clear();
+
+	FString message;
+	if (m_ReplayRecorder.IsRecording() && !m_ReplayRecorder.Save(message))
+	{
+		if (GEngine) GEngine->AddOnScreenDebugMessage(-1, 60.0f, FColor::Green, message);
+	}
+}
+
+//-----------------------------------\\
+//--                               --\\
+//--            GETTERS            --\\
+//--                               --\\
+//-----------------------------------\\
+
+//Designed to retrieve an actor with a specific name from
+//a provided array of actors (CPActors). The method also
+//sets a success flag and provides an information message
+//to indicate whether the actor was successfully located or not.
+AActor* UGameData::GetActorByName(const FString& ActorName, TArray<AActor*> CPActors, UWorld* World, bool& success, FString& infoMessage)
+{
+	for (AActor* cp : CPActors)
+	{
+		if (cp && cp->Tags[0] == FName(ActorName))
+		{
+			success = true;
+			infoMessage = FString("Actor Found");
+			return cp;
+		}
+	}
+	success = false;
+	infoMessage = FString("Actor Not Found");;
+	return nullptr;
+}
+
+//Retrieves the actor of a checkpoint. With the resolved reference table,
+//the actor is found through its object path, and a checkpoint of the table
+//that does not resolve, for instance because its sublevel is not loaded,
+//is not found. Checkpoints missing from the table are matched by name as
+//before.
+AActor* UGameData::GetCheckpointActor(const FString& CheckpointName, const TArray<AActor*>& CPActors, UWorld* World, bool& success, FString& infoMessage) const
+{
+	const FString* actorPath = m_UseResolvedReferences ? m_ResolvedReferences.Checkpoints.Find(CheckpointName) : nullptr;
+	if (!actorPath)
+	{
+		return GetActorByName(CheckpointName, CPActors, World, success, infoMessage);
+	}
+
+	FSoftObjectPath objectPath(*actorPath);
+#if WITH_EDITOR
+	objectPath.FixupForPIE();
+#endif
+	AActor* actor = Cast<AActor>(objectPath.ResolveObject());
+	success = actor != nullptr;
+	infoMessage = actor ? FString("Actor Found") : FString::Printf(TEXT("Actor Not Found %s"), *CheckpointName);
+	return actor;
+}
+
+//Retrieves assets by name through the resolved reference table alone:
+//the content was validated offline, so the name index is neither built
+//nor checked. An asset that is not loaded is reported instead of loaded
+//on the spot, which would stall the game thread. Each missing name is
+//reported once.
+template<typename T>
+TArray<T*> UGameData::GetResolvedAssets(const TArray<FString>& AssetNames, const TMap<FString, FString>& AssetPaths, TAssetNameResolver<T>& MissingAssets, const TCHAR* AssetKind) const
+{
+	TArray<T*> assets;
+	for (const FString& assetName : AssetNames)
+	{
+		const FString* assetPath = AssetPaths.Find(assetName);
+		T* asset = assetPath ? Cast<T>(FSoftObjectPath(*assetPath).ResolveObject()) : nullptr;
+		if (asset)
+		{
+			assets.AddUnique(asset);
+		}
+		else if (MissingAssets.MarkMissing(assetName))
+		{
+			if (GEngine) GEngine->AddOnScreenDebugMessage(-1, 60.0f, FColor::Green, FString::Printf(TEXT("%s Not Found %s"), AssetKind, *assetName));
+		}
+	}
+	return assets;
+}
+
+//Designed to retrieve an array of sound assets based on a
+//provided array of sound names (SoundNames) and an existing
+//array of sound assets (NarrativeSounds). The names are looked up
+//in an index of the array, and unknown names are reported only once.
+//When the resolved reference table is loaded, it is used instead.
+TArray<USoundBase*> UGameData::GetSoundByName(const TArray<FString>& SoundNames, const TArray<USoundBase*>& NarrativeSounds)
+{
+	SyncSoundNames(NarrativeSounds);
+	return FindSounds(SoundNames);
+}
+
+//Designed to retrieve an array of images assets based on a
+//provided array of images names (ImageNames) and an existing
+//array of images assets (Images). The names are looked up
+//in an index of the array, and unknown names are reported only once.
+//When the resolved reference table is loaded, it is used instead.
+TArray<UTexture2D*> UGameData::GetImageByName(const TArray<FString>& ImageNames, const TArray<UTexture2D*>& Images)
+{
+	SyncImageNames(Images);
+	return FindImages(ImageNames);
+}
+
+//Syncs the sound name index with the sounds a load looks names up in.
+//Nothing to do with the resolved reference table, which finds sounds by
+//their object path.
+void UGameData::SyncSoundNames(const TArray<USoundBase*>& Sounds)
+{
+	if (!m_UseResolvedReferences)
+	{
+		m_SoundNameResolver.Sync(Sounds);
+	}
+}
+
+//Same as SyncSoundNames for the image name index.
+void UGameData::SyncImageNames(const TArray<UTexture2D*>& Images)
+{
+	if (!m_UseResolvedReferences)
+	{
+		m_ImageNameResolver.Sync(Images);
+	}
+}
+
+//Same as GetSoundByName, in the sounds the index was last synced with.
+//The loaders sync the index once per load rather than for every name.
+TArray<USoundBase*> UGameData::FindSounds(const TArray<FString>& SoundNames)
+{
+	if (m_UseResolvedReferences)
+	{
+		return GetResolvedAssets<USoundBase>(SoundNames, m_ResolvedReferences.Sounds, m_SoundNameResolver, TEXT("Sound"));
+	}
+
+	TArray<USoundBase*> sounds;
+	for (const FString& soundName : SoundNames)
+	{
+		bool isFirstMiss;
+		if (!m_SoundNameResolver.Find(soundName, sounds, isFirstMiss) && isFirstMiss)
+		{
+			if (GEngine) GEngine->AddOnScreenDebugMessage(-1, 60.0f, FColor::Green, FString::Printf(TEXT("Sound Not Found %s"), *soundName));
+		}
+	}
+	return sounds;
+}
+
+//Same as GetImageByName, in the images the index was last synced with.
+TArray<UTexture2D*> UGameData::FindImages(const TArray<FString>& ImageNames)
+{
+	if (m_UseResolvedReferences)
+	{
+		return GetResolvedAssets<UTexture2D>(ImageNames, m_ResolvedReferences.Images, m_ImageNameResolver, TEXT("Image"));
+	}
+
+	TArray<UTexture2D*> foundImages;
+	for (const FString& imageName : ImageNames)
+	{
+		bool isFirstMiss;
+		if (!m_ImageNameResolver.Find(imageName, foundImages, isFirstMiss) && isFirstMiss)
+		{
+			if (GEngine) GEngine->AddOnScreenDebugMessage(-1, 60.0f, FColor::Green, FString::Printf(TEXT("Image Not Found %s"), *imageName));
+		}
+	}
 	return foundImages;
 }
 
+//Reads the table of references resolved offline by the content
+//validation commandlet. Once loaded, sounds, images and checkpoint
+//actors are found through their object path instead of matching names. Shipping builds
+//load it at startup, since the content was validated when cooking.
+bool UGameData::LoadResolvedReferences(const FString& path)
+{
+	FGameDataLatencyScope latencyScope(TEXT("LoadResolvedReferences"), m_SessionState);
+	bool success;
+	FString message;
+
+	m_ResolvedReferences = m_ParseCache.ReadStructFromJsonFile<FResolvedReferenceTable>(m_JsonHelper, path, success, message);
+	m_UseResolvedReferences = success;
+
+	if (!success)
+	{
+		if (GEngine) GEngine->AddOnScreenDebugMessage(-1, 60.0f, FColor::Green, message);
+	}
+
+	return success;
+}
+
 //Converts a given string representation of an instruction
 //type (InstructionType) into its corresponding enumerated
 //value from the Instructions enum.
@@ -312,4 +1369,404 @@ Instructions UGameData::StringToInstructions(const FString& InstructionType)
 	if (InstructionType == "MiniGameQuiz_QuestionInstruction") return Instructions::MiniGameQuiz_QuestionInstruction;
 	if (InstructionType == "Inactivity_Instruction") return Instructions::Inactivty_Instruction;
 	return Instructions::LearnMoreProposed;
-}
\ No newline at end of file
+}
+
+//Returns the caption timelines of the given instruction,
+//or nullptr if the instruction was not loaded.
+const FNarrationCaptionTimelines* UGameData::GetInstructionCaptionTimelines(Instructions Instruction) const
+{
+	return m_InstructionCaptionTimelines.Find(Instruction);
+}
+
+//Returns the caption timelines of the given checkpoint actor,
+//or nullptr if the checkpoint was not loaded.
+const FNarrationCaptionTimelines* UGameData::GetCheckpointCaptionTimelines(AActor* Checkpoint) const
+{
+	return m_ActiveTour.m_CaptionTimelines.Find(Checkpoint);
+}
+
+//Returns the caption timelines of a learn more entry, using the
+//same index as the LearnMoreData returned by PopulateLearnMoreUI.
+const FNarrationCaptionTimelines* UGameData::GetLearnMoreCaptionTimelines(int LearnMoreIndex) const
+{
+	return m_LearnMoreCaptionTimelines.IsValidIndex(LearnMoreIndex) ? &m_LearnMoreCaptionTimelines[LearnMoreIndex] : nullptr;
+}
+
+//Builds the English and French caption timelines of a narration entry.
+//Start times provided in the JSON (DataIndex of the timing data) take
+//precedence over the ones derived from the sound durations.
+FNarrationCaptionTimelines UGameData::BuildCaptionTimelines(const FCaptionTimingData& TimingData, int DataIndex, int32 NumCaptions, const TArray<USoundBase*>& EnglishSounds, const TArray<USoundBase*>& FrenchSounds) const
+{
+	static const FCaptionTimingEntry NoTiming;
+	const FCaptionTimingEntry& timing = TimingData.Data.IsValidIndex(DataIndex) ? TimingData.Data[DataIndex] : NoTiming;
+
+	FNarrationCaptionTimelines timelines;
+	timelines.m_English = FCaptionTimeline::Build(timing.EnglishCaptionStartTimes, EnglishSounds, NumCaptions);
+	timelines.m_French = FCaptionTimeline::Build(timing.FrenchCaptionStartTimes, FrenchSounds, NumCaptions);
+	return timelines;
+}
+
+//Returns the caption ids of the given instruction,
+//or nullptr if the instruction was not loaded.
+const FNarrationCaptionIds* UGameData::GetInstructionCaptionIds(Instructions Instruction) const
+{
+	return m_InstructionCaptionIds.Find(Instruction);
+}
+
+//Returns the caption ids of the given checkpoint actor,
+//or nullptr if the checkpoint was not loaded.
+const FNarrationCaptionIds* UGameData::GetCheckpointCaptionIds(AActor* Checkpoint) const
+{
+	return m_ActiveTour.m_CaptionIds.Find(Checkpoint);
+}
+
+//Returns the caption ids of a learn more entry, using the
+//same index as the LearnMoreData returned by PopulateLearnMoreUI.
+const FNarrationCaptionIds* UGameData::GetLearnMoreCaptionIds(int LearnMoreIndex) const
+{
+	return m_LearnMoreCaptionIds.IsValidIndex(LearnMoreIndex) ? &m_LearnMoreCaptionIds[LearnMoreIndex] : nullptr;
+}
+
+//Returns the shared asset lists of the given instruction,
+//or nullptr if the instruction was not loaded.
+const FNarrationAssetLists* UGameData::GetInstructionAssetLists(Instructions Instruction) const
+{
+	return m_InstructionAssetLists.Find(Instruction);
+}
+
+//Returns the shared asset lists of the given checkpoint actor,
+//or nullptr if the checkpoint was not loaded.
+const FNarrationAssetLists* UGameData::GetCheckpointAssetLists(AActor* Checkpoint) const
+{
+	return m_ActiveTour.m_AssetLists.Find(Checkpoint);
+}
+
+//Returns the shared asset lists of a learn more entry, using the
+//same index as the LearnMoreData returned by PopulateLearnMoreUI.
+const FNarrationAssetLists* UGameData::GetLearnMoreAssetLists(int LearnMoreIndex) const
+{
+	return m_LearnMoreAssetLists.IsValidIndex(LearnMoreIndex) ? &m_LearnMoreAssetLists[LearnMoreIndex] : nullptr;
+}
+
+//Returns the shared asset lists of a quiz tile, using the same
+//index as the LearnMoreKeyMap returned by PopulateQuizUI.
+const FNarrationAssetLists* UGameData::GetQuizTileAssetLists(int TileIndex) const
+{
+	return m_QuizTileAssetLists.IsValidIndex(TileIndex) ? &m_QuizTileAssetLists[TileIndex] : nullptr;
+}
+
+//Returns the text of a caption id for the active culture.
+const FText& UGameData::GetCaptionText(int32 CaptionId) const
+{
+	return m_CaptionTexts.GetText(CaptionId);
+}
+
+//Sets the string table the caption keys are resolved from.
+//Already registered captions are resolved again in the background.
+void UGameData::SetCaptionStringTable(FName StringTableId)
+{
+	m_CaptionTexts.SetStringTableId(StringTableId);
+	OnCultureChanged();
+}
+
+//Shares the caption texts with the other game processes of the machine
+//that load the same content, see FCaptionTextTable::Share. Enabled at
+//startup with -SharedGameData on multi-screen installations.
+bool UGameData::ShareCaptionTexts()
+{
+	return m_CaptionTexts.Share();
+}
+
+//Returns the checkpoints and learn more panels whose captions contain a
+//word starting with each word of the query, in tour order. Answers from
+//the last index built, so results follow the loads a frame or two late.
+TArray<FCaptionSearchHit> UGameData::SearchCaptions(const FString& Query, int32 MaxHits) const
+{
+	FGameDataLatencyScope latencyScope(TEXT("SearchCaptions"), m_SessionState);
+	return m_CaptionSearch.Search(Query, MaxHits);
+}
+
+//Registers the title and caption keys of a narration
+//in the text table and returns their ids.
+FNarrationCaptionIds UGameData::RegisterCaptionIds(const FString& TitleKey, const TArray<FString>& Keys)
+{
+	FNarrationCaptionIds captionIds;
+	captionIds.m_TitleId = m_CaptionTexts.RegisterKey(TitleKey);
+	captionIds.m_KeyIds.Reserve(Keys.Num());
+	for (const FString& key : Keys)
+	{
+		captionIds.m_KeyIds.Add(m_CaptionTexts.RegisterKey(key));
+	}
+	return captionIds;
+}
+
+//Releases the ids RegisterCaptionIds returned, once nothing uses them.
+void UGameData::ReleaseCaptionIds(const FNarrationCaptionIds& CaptionIds)
+{
+	m_CaptionTexts.ReleaseKey(CaptionIds.m_TitleId);
+	for (int32 keyId : CaptionIds.m_KeyIds)
+	{
+		m_CaptionTexts.ReleaseKey(keyId);
+	}
+}
+
+//Measures the memory used by the content returned by the last loads
+//and by the caches and indexes UGameData keeps between them.
+FGameDataMemoryReport UGameData::GetMemoryReport() const
+{
+	FGameDataMemoryReport report;
+	for (const auto& content : m_ContentMemory)
+	{
+		report.Append(content.Value);
+	}
+
+	report.Add(EGameDataMemoryCategory::CaptionStrings, m_CaptionTexts.GetAllocatedSize());
+	report.Add(EGameDataMemoryCategory::Maps, m_InstructionCaptionTimelines.GetAllocatedSize() + m_ActiveTour.m_CaptionTimelines.GetAllocatedSize()
+		+ m_LearnMoreCaptionTimelines.GetAllocatedSize() + m_InstructionCaptionIds.GetAllocatedSize() + m_ActiveTour.m_CaptionIds.GetAllocatedSize()
+		+ m_LearnMoreCaptionIds.GetAllocatedSize() + m_LearnMoreSearchEntries.GetAllocatedSize() + m_InstructionAssetLists.GetAllocatedSize() + m_ActiveTour.m_AssetLists.GetAllocatedSize()
+		+ m_LearnMoreAssetLists.GetAllocatedSize() + m_QuizTileAssetLists.GetAllocatedSize() + m_LearnMoreIds.GetAllocatedSize()
+		+ m_ActiveTour.m_CheckpointIndices.GetAllocatedSize());
+
+	//The rows of the sharded tour are kept to build the shards that stream in.
+	report.Add(EGameDataMemoryCategory::NarrationStructs, m_ShardedCheckpoints.Data.GetAllocatedSize() + m_ShardedTimings.Data.GetAllocatedSize());
+
+	SIZE_T indexesSize = m_ActiveTour.m_Flags.GetAllocatedSize() + m_ActiveTour.m_Graph.GetAllocatedSize() + m_ContentShards.GetAllocatedSize() + m_ShardedActors.GetAllocatedSize()
+		+ m_SoundNameResolver.GetAllocatedSize() + m_ImageNameResolver.GetAllocatedSize();
+	for (const auto& timelines : m_InstructionCaptionTimelines)
+	{
+		indexesSize += timelines.Value.GetAllocatedSize();
+	}
+	for (const auto& timelines : m_ActiveTour.m_CaptionTimelines)
+	{
+		indexesSize += timelines.Value.GetAllocatedSize();
+	}
+	for (const FNarrationCaptionTimelines& timelines : m_LearnMoreCaptionTimelines)
+	{
+		indexesSize += timelines.GetAllocatedSize();
+	}
+	for (const auto& captionIds : m_InstructionCaptionIds)
+	{
+		indexesSize += captionIds.Value.GetAllocatedSize();
+	}
+	for (const auto& captionIds : m_ActiveTour.m_CaptionIds)
+	{
+		indexesSize += captionIds.Value.GetAllocatedSize();
+	}
+	for (const FNarrationCaptionIds& captionIds : m_LearnMoreCaptionIds)
+	{
+		indexesSize += captionIds.GetAllocatedSize();
+	}
+	for (const FLearnMoreSearchEntry& entry : m_LearnMoreSearchEntries)
+	{
+		indexesSize += entry.m_CaptionIds.GetAllocatedSize();
+	}
+	indexesSize += m_CaptionSearch.GetAllocatedSize();
+	report.Add(EGameDataMemoryCategory::Indexes, indexesSize);
+	report.Add(EGameDataMemoryCategory::AssetLists, m_SoundListPool.GetAllocatedSize() + m_ImageListPool.GetAllocatedSize());
+
+	//The scheduler keeps its own copy of the instructions, without sounds.
+	report.Measure(m_InstructionScheduler.GetInstructions());
+
+	for (const TWeakObjectPtr<UProgressBar>& progressBar : m_CreatedProgressBars)
+	{
+		if (progressBar.IsValid())
+		{
+			report.Add(EGameDataMemoryCategory::Widgets, progressBar->GetClass()->GetStructureSize() + progressBar->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal));
+		}
+	}
+
+	TSet<USoundBase*> sounds;
+	for (const TArray<USoundBase*>& list : m_SoundListPool.GetLists())
+	{
+		sounds.Append(list);
+	}
+	for (USoundBase* sound : sounds)
+	{
+		report.Add(EGameDataMemoryCategory::Sounds, sound ? sound->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal) : 0);
+	}
+
+	TSet<UTexture2D*> textures;
+	for (const TArray<UTexture2D*>& list : m_ImageListPool.GetLists())
+	{
+		textures.Append(list);
+	}
+	for (UTexture2D* texture : textures)
+	{
+		report.Add(EGameDataMemoryCategory::Textures, texture ? texture->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal) : 0);
+	}
+
+	return report;
+}
+
+//Logs the memory report, first for each loaded content file
+//and then for everything UGameData holds.
+void UGameData::ReportMemory(FOutputDevice& Ar) const
+{
+	for (const auto& content : m_ContentMemory)
+	{
+		content.Value.Log(Ar, content.Key);
+	}
+	GetMemoryReport().Log(Ar, GetName() + TEXT(" total"));
+	if (const FSharedContentSegment* segment = m_CaptionTexts.GetSharedSegment())
+	{
+		Ar.Logf(TEXT("  Shared captions %s: %d captions, %.1f KB, %s"), *segment->GetName(), segment->Num(), segment->GetSize() / 1024.0,
+			segment->IsPublisher() ? TEXT("published") : TEXT("mapped"));
+	}
+}
+
+//Interns the resolved asset lists of a narration, so identical
+//lists referenced by several narrations are stored only once.
+FNarrationAssetLists UGameData::InternAssetLists(const TArray<USoundBase*>& EnglishSounds, const TArray<USoundBase*>& FrenchSounds, const TArray<UTexture2D*>& Images)
+{
+	FNarrationAssetLists assetLists;
+	assetLists.m_EnglishSounds = m_SoundListPool.Intern(EnglishSounds);
+	assetLists.m_FrenchSounds = m_SoundListPool.Intern(FrenchSounds);
+	assetLists.m_Images = m_ImageListPool.Intern(Images);
+	return assetLists;
+}
+
+//Drops the asset lists no narration references anymore, once a tour
+//replaced another, so the pools do not grow from tour to tour.
+void UGameData::CompactAssetLists()
+{
+	TArray<FAssetListHandle*> soundHandles;
+	TArray<FAssetListHandle*> imageHandles;
+	const auto addHandles = [&](FNarrationAssetLists& assetLists)
+	{
+		soundHandles.Add(&assetLists.m_EnglishSounds);
+		soundHandles.Add(&assetLists.m_FrenchSounds);
+		imageHandles.Add(&assetLists.m_Images);
+	};
+	for (auto& assetLists : m_InstructionAssetLists)
+	{
+		addHandles(assetLists.Value);
+	}
+	for (FTourState* tour : { &m_ActiveTour, &m_StagingTour })
+	{
+		for (auto& assetLists : tour->m_AssetLists)
+		{
+			addHandles(assetLists.Value);
+		}
+	}
+	for (FNarrationAssetLists& assetLists : m_LearnMoreAssetLists)
+	{
+		addHandles(assetLists);
+	}
+	for (FNarrationAssetLists& assetLists : m_QuizTileAssetLists)
+	{
+		addHandles(assetLists);
+	}
+	m_SoundListPool.Compact(soundHandles);
+	m_ImageListPool.Compact(imageHandles);
+}
+
+//Reports the assets referenced by the asset list pools and the name
+//indexes, which are not properties, to the garbage collector.
+void UGameData::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	UGameData* gameData = CastChecked<UGameData>(InThis);
+	gameData->m_SoundListPool.AddReferencedObjects(Collector);
+	gameData->m_ImageListPool.AddReferencedObjects(Collector);
+	gameData->m_SoundNameResolver.AddReferencedObjects(Collector);
+	gameData->m_ImageNameResolver.AddReferencedObjects(Collector);
+	Super::AddReferencedObjects(InThis, Collector);
+}
+
+//Queues a rebuild of the caption search index on the game thread, so
+//several loads of the same frame are indexed once.
+void UGameData::RequestCaptionSearchRebuild()
+{
+	if (m_IsCaptionSearchQueued)
+	{
+		return;
+	}
+	m_IsCaptionSearchQueued = true;
+
+	TWeakObjectPtr<UGameData> weakThis(this);
+	AsyncTask(ENamedThreads::GameThread, [weakThis]()
+	{
+		if (UGameData* gameData = weakThis.Get())
+		{
+			gameData->RebuildCaptionSearch();
+		}
+	});
+}
+
+//Gathers the caption texts of the loaded checkpoints and of every entry
+//of the loaded learn more file and indexes them on a worker thread. The new index is swapped in on the
+//game thread unless a newer rebuild was started meanwhile.
+void UGameData::RebuildCaptionSearch()
+{
+	m_IsCaptionSearchQueued = false;
+
+	const auto getTexts = [this](const FNarrationCaptionIds& CaptionIds)
+	{
+		TArray<FString> texts;
+		texts.Reserve(CaptionIds.m_KeyIds.Num() + 1);
+		texts.Add(FString(m_CaptionTexts.GetString(CaptionIds.m_TitleId)));
+		for (int32 keyId : CaptionIds.m_KeyIds)
+		{
+			texts.Add(FString(m_CaptionTexts.GetString(keyId)));
+		}
+		return texts;
+	};
+
+	TArray<FCaptionSearchDocument> documents;
+	for (const auto& captionIds : m_ActiveTour.m_CaptionIds)
+	{
+		if (const int32* checkpointIndex = m_ActiveTour.m_CheckpointIndices.Find(captionIds.Key))
+		{
+			FCaptionSearchDocument& document = documents.AddDefaulted_GetRef();
+			document.m_Hit.m_Source = ECaptionSearchSource::Checkpoint;
+			document.m_Hit.m_CheckpointIndex = *checkpointIndex;
+			document.m_Texts = getTexts(captionIds.Value);
+		}
+	}
+	documents.Sort([](const FCaptionSearchDocument& A, const FCaptionSearchDocument& B) { return A.m_Hit.m_CheckpointIndex < B.m_Hit.m_CheckpointIndex; });
+
+	for (const FLearnMoreSearchEntry& entry : m_LearnMoreSearchEntries)
+	{
+		FCaptionSearchDocument& document = documents.AddDefaulted_GetRef();
+		document.m_Hit = entry.m_Hit;
+		document.m_Texts = getTexts(entry.m_CaptionIds);
+	}
+
+	const int32 generation = ++m_CaptionSearchGeneration;
+	TWeakObjectPtr<UGameData> weakThis(this);
+	Async(EAsyncExecution::ThreadPool, [weakThis, generation, documents = MoveTemp(documents)]()
+	{
+		FCaptionSearchIndex index = FCaptionSearchIndex::Build(documents);
+		AsyncTask(ENamedThreads::GameThread, [weakThis, generation, index = MoveTemp(index)]() mutable
+		{
+			UGameData* gameData = weakThis.Get();
+			if (gameData && gameData->m_CaptionSearchGeneration == generation)
+			{
+				gameData->m_CaptionSearch = MoveTemp(index);
+			}
+		});
+	});
+}
+
+//Rebuilds the caption text table for the new culture on a worker
+//thread. The current texts stay displayed until the new table is
+//swapped in on the game thread, so the switch never blocks a frame.
+void UGameData::OnCultureChanged()
+{
+	TArray<FString> keys;
+	FName stringTableId;
+	const int32 generation = m_CaptionTexts.BeginRebuild(keys, stringTableId);
+
+	TWeakObjectPtr<UGameData> weakThis(this);
+	Async(EAsyncExecution::ThreadPool, [weakThis, generation, stringTableId, keys = MoveTemp(keys)]()
+	{
+		TArray<FText> texts = FCaptionTextTable::ResolveKeys(stringTableId, keys);
+		AsyncTask(ENamedThreads::GameThread, [weakThis, generation, texts = MoveTemp(texts)]() mutable
+		{
+			if (UGameData* gameData = weakThis.Get())
+			{
+				gameData->m_CaptionTexts.ApplyRebuild(generation, MoveTemp(texts));
+				gameData->RequestCaptionSearchRebuild();
+			}
+		});
+	});
+}
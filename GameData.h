@@ -4,6 +4,24 @@
 
 #include "CoreMinimal.h"
 #include "JsonHelper.h"
+#include "CaptionTimeline.h"
+#include "CaptionTextTable.h"
+#include "InstructionScheduler.h"
+#include "CheckpointFlags.h"
+#include "TourGraph.h"
+#include "QuizQuestionBank.h"
+#include "SessionState.h"
+#include "JsonParseCache.h"
+#include "ResolvedReferences.h"
+#include "AssetNameResolver.h"
+#include "AssetListPool.h"
+#include "GameDataMemory.h"
+#include "TourReplay.h"
+#include "GameDataPipeline.h"
+#include "ContentShards.h"
+#include "ContentLoader.h"
+#include "ContentRequestScheduler.h"
+#include "CaptionSearchIndex.h"
 #include "Components/Button.h"
 #include "Components/HorizontalBox.h"
 #include "Components/VerticalBox.h"
@@ -12,6 +30,56 @@
 #include "Sound/SoundBase.h"
 #include "GameData.generated.h"
 
+//What LoadTourSegmentAsync loads when the visitor moves to another
+//part of the tour. Empty paths and a null box skip their step.
+struct FTourSegmentRequest
+{
+	FString m_CheckpointsPath;
+	FString m_LearnMorePath;
+	FString m_QuizPath;
+	int m_CheckpointIndex = 0;
+	TArray<USoundBase*> m_NarrativeSounds;
+	TArray<UTexture2D*> m_Images;
+	TArray<AActor*> m_CPActors;
+	UHorizontalBox* m_ProgressBarsBox = nullptr;
+	FProgressBarStyle m_ProgressBarStyle;
+};
+
+struct FTourSegment
+{
+	FCheckpointsGameData m_Checkpoints;
+	FLearnMoreGameData m_LearnMore;
+	TArray<UProgressBar*> m_ProgressBars;
+	FQuizQuestions m_QuizQuestions;
+	FTilesGameData m_QuizTiles;
+};
+
+//Checkpoint content of a tour. UGameData keeps the active tour and a
+//staging tour prepared in the background, and swaps them in one step.
+struct FTourState
+{
+	FString m_Path;
+	uint32 m_TourKey = 0;
+	FCheckpointsGameData m_Checkpoints;
+	TMap<AActor*, FNarrationCaptionTimelines> m_CaptionTimelines;
+	TMap<AActor*, FNarrationCaptionIds> m_CaptionIds;
+	TMap<AActor*, FNarrationAssetLists> m_AssetLists;
+	TMap<AActor*, int32> m_CheckpointIndices;
+	FCheckpointFlags m_Flags;
+	FTourGraph m_Graph;
+	TArray<int32> m_FrameNumbers;
+};
+
+//Caption ids of an entry of the loaded learn more file, kept for the
+//caption search whichever learn more panel is on screen.
+struct FLearnMoreSearchEntry
+{
+	FCaptionSearchHit m_Hit;
+	FNarrationCaptionIds m_CaptionIds;
+};
+
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnContentShardChanged, int32 /*Shard*/, bool /*bLoaded*/, const FCheckpointsGameData&);
+
 UCLASS()
 class COLDWARPROJECT_API UGameData : public UObject
 {
@@ -19,6 +87,7 @@ class COLDWARPROJECT_API UGameData : public UObject
 
 public:
 	void GameData();
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
 	UPROPERTY()
 		UJsonHelper* m_JsonHelper;
 
@@ -29,6 +98,7 @@ public:
 	//-----------------------------------\\
 
 	FInstructionGameData LoadInstructionsData(UWorld* World, FString path, TArray<USoundBase*> NarrativeSounds);
+	FInstructionScheduler& GetInstructionScheduler() { return m_InstructionScheduler; }
 
 	//-----------------------------------\\
 	//--                               --\\
@@ -37,8 +107,19 @@ public:
 	//-----------------------------------\\
 
 	FCheckpointsGameData LoadCheckpointsData(UWorld* World, FString path, TArray<USoundBase*> NarrativeSounds, TArray<AActor*> CPActors);
+	FCheckpointsGameData LoadCheckpointsDataSharded(UWorld* World, FString path, TArray<USoundBase*> NarrativeSounds);
+	const FContentShards& GetContentShards() const { return m_ContentShards; }
+	FOnContentShardChanged& OnContentShardChanged() { return m_OnContentShardChanged; }
+	TSharedRef<FGameDataPipeline> PrepareTourAsync(UWorld* World, FString path, TArray<USoundBase*> NarrativeSounds, TArray<AActor*> CPActors, TUniqueFunction<void(bool)>&& OnPrepared = nullptr);
+	bool IsTourStaged() const { return m_IsTourStaged; }
+	FCheckpointsGameData SwapStagedTour();
+	FContentRequestToken RequestLearnMoreContent(const FString& JSONpath, int32 CheckpointIndex, EContentRequestPriority Priority, TUniqueFunction<void()>&& OnReady = nullptr);
+	const FContentRequestScheduler& GetContentRequests() const { return m_ContentRequests; }
+	const FCheckpointFlags& GetCheckpointFlags() const { return m_ActiveTour.m_Flags; }
+	const FTourGraph& GetTourGraph() const { return m_ActiveTour.m_Graph; }
 	FLearnMoreGameData PopulateLearnMoreUI(FString JSONpath, int CurrentActorIndex, TArray<USoundBase*> NarrativeSounds, TArray<UTexture2D*> Images);
 	TArray<UProgressBar*> LoadLearnMoreProgressBar(UHorizontalBox* progressBarsBox, FProgressBarStyle progressBarStyle, int numberOfLearnMoreOptions) const;
+	TSharedRef<FGameDataPipeline> LoadTourSegmentAsync(UWorld* World, const FTourSegmentRequest& Request, TUniqueFunction<void(bool, const FTourSegment&)>&& OnLoaded);
 
 	//-----------------------------------\\
 	//--                               --\\
@@ -47,7 +128,25 @@ public:
 	//-----------------------------------\\
 
 	FQuizQuestions LoadQuizQuestions() const;
+	bool OpenQuizQuestionBank(const FString& IndexPath);
+	FQuizQuestions LoadQuizQuestionsSample(int32 NumQuestions, FRandomStream& RandomStream, int32 CorrespondingCPIndex = INDEX_NONE);
 	FTilesGameData PopulateQuizUI(TArray<USoundBase*> NarrativeSounds, const FQuizQuestions& QuizQuestions, int32 CurrentQuestionIndex);
+	void RecordQuizAnswer(int32 SelectedOptionIndex) const;
+
+	//-----------------------------------\\
+	//--                               --\\
+	//--         SESSION STATE         --\\
+	//--                               --\\
+	//-----------------------------------\\
+
+	void MarkCheckpointReached(int32 CheckpointIndex);
+	void MarkLearnMoreCompleted(int LearnMoreIndex);
+	void MarkQuizAnswered(int32 QuestionIndex, int32 SelectedOptionIndex);
+	bool IsLearnMoreCompleted(int LearnMoreIndex) const;
+	bool RestoreSessionState();
+	void ClearSessionState();
+	const FVisitorSessionState& GetSessionState() const { return m_SessionState; }
+	void UseScratchDir(const FString& Dir);
 
 	//-----------------------------------\\
 	//--                               --\\
@@ -56,7 +155,115 @@ public:
 	//-----------------------------------\\
 
 	static AActor* GetActorByName(const FString& ActorName, TArray<AActor*> CPActors, UWorld* World, bool& success, FString& infoMessage);
-	TArray<USoundBase*> GetSoundByName(const TArray<FString> SoundNames, TArray<USoundBase*> NarrativeSounds);
-	TArray<UTexture2D*> GetImageByName(const TArray<FString> ImageNames, TArray<UTexture2D*> Images);
+	AActor* GetCheckpointActor(const FString& CheckpointName, const TArray<AActor*>& CPActors, UWorld* World, bool& success, FString& infoMessage) const;
+	TArray<USoundBase*> GetSoundByName(const TArray<FString>& SoundNames, const TArray<USoundBase*>& NarrativeSounds);
+	TArray<UTexture2D*> GetImageByName(const TArray<FString>& ImageNames, const TArray<UTexture2D*>& Images);
 	static Instructions StringToInstructions(const FString& InstructionType);
+	bool LoadResolvedReferences(const FString& path);
+	const FNarrationAssetLists* GetInstructionAssetLists(Instructions Instruction) const;
+	const FNarrationAssetLists* GetCheckpointAssetLists(AActor* Checkpoint) const;
+	const FNarrationAssetLists* GetLearnMoreAssetLists(int LearnMoreIndex) const;
+	const FNarrationAssetLists* GetQuizTileAssetLists(int TileIndex) const;
+	const TArray<USoundBase*>& GetSoundList(FAssetListHandle Handle) const { return m_SoundListPool.Get(Handle); }
+	const TArray<UTexture2D*>& GetImageList(FAssetListHandle Handle) const { return m_ImageListPool.Get(Handle); }
+	FGameDataMemoryReport GetMemoryReport() const;
+	void ReportMemory(FOutputDevice& Ar) const;
+	const FNarrationCaptionTimelines* GetInstructionCaptionTimelines(Instructions Instruction) const;
+	const FNarrationCaptionTimelines* GetCheckpointCaptionTimelines(AActor* Checkpoint) const;
+	const FNarrationCaptionTimelines* GetLearnMoreCaptionTimelines(int LearnMoreIndex) const;
+	const FNarrationCaptionIds* GetInstructionCaptionIds(Instructions Instruction) const;
+	const FNarrationCaptionIds* GetCheckpointCaptionIds(AActor* Checkpoint) const;
+	const FNarrationCaptionIds* GetLearnMoreCaptionIds(int LearnMoreIndex) const;
+	const FText& GetCaptionText(int32 CaptionId) const;
+	void SetCaptionStringTable(FName StringTableId);
+	bool ShareCaptionTexts();
+	TArray<FCaptionSearchHit> SearchCaptions(const FString& Query, int32 MaxHits = 20) const;
+
+private:
+	FCheckpointsGameData LoadCheckpointsData(UWorld* World, const FJsonContentFile& File, const TArray<USoundBase*>& NarrativeSounds, const TArray<AActor*>& CPActors);
+	FLearnMoreGameData PopulateLearnMoreUI(const FJsonContentFile& File, int CurrentActorIndex, const TArray<USoundBase*>& NarrativeSounds, const TArray<UTexture2D*>& Images);
+	FNarrationKeys LoadCheckpointNarration(FTourState& Tour, const FCheckpointsData& DataStructure, const FCaptionTimingData& TimingData, int Index, AActor* Actor);
+	TArray<USoundBase*> FindSounds(const TArray<FString>& SoundNames);
+	TArray<UTexture2D*> FindImages(const TArray<FString>& ImageNames);
+	void SyncSoundNames(const TArray<USoundBase*>& Sounds);
+	void SyncImageNames(const TArray<UTexture2D*>& Images);
+	FCheckpointsGameData LoadCheckpointShard(int32 Shard, ULevel* Level, const FContentLoadContext* TourContext = nullptr);
+	FContentLoadEnvironment GetLoadEnvironment() const;
+	void UnloadCheckpointShard(int32 Shard);
+	void ResetShardedTour();
+	void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+	void OnLevelRemovedFromWorld(ULevel* Level, UWorld* World);
+	FNarrationCaptionTimelines BuildCaptionTimelines(const FCaptionTimingData& TimingData, int DataIndex, int32 NumCaptions, const TArray<USoundBase*>& EnglishSounds, const TArray<USoundBase*>& FrenchSounds) const;
+	FNarrationCaptionIds RegisterCaptionIds(const FString& TitleKey, const TArray<FString>& Keys);
+	void ReleaseCaptionIds(const FNarrationCaptionIds& CaptionIds);
+	FNarrationAssetLists InternAssetLists(const TArray<USoundBase*>& EnglishSounds, const TArray<USoundBase*>& FrenchSounds, const TArray<UTexture2D*>& Images = TArray<UTexture2D*>());
+	void CompactAssetLists();
+	void OnCultureChanged();
+	void RequestCaptionSearchRebuild();
+	void RebuildCaptionSearch();
+	template<typename T>
+	TArray<T*> GetResolvedAssets(const TArray<FString>& AssetNames, const TMap<FString, FString>& AssetPaths, TAssetNameResolver<T>& MissingAssets, const TCHAR* AssetKind) const;
+
+	TMap<Instructions, FNarrationCaptionTimelines> m_InstructionCaptionTimelines;
+	TArray<FNarrationCaptionTimelines> m_LearnMoreCaptionTimelines;
+
+	FCaptionTextTable m_CaptionTexts;
+	FCaptionSearchIndex m_CaptionSearch;
+	int32 m_CaptionSearchGeneration = 0;
+	bool m_IsCaptionSearchQueued = false;
+	TMap<Instructions, FNarrationCaptionIds> m_InstructionCaptionIds;
+	TArray<FNarrationCaptionIds> m_LearnMoreCaptionIds;
+	TArray<FLearnMoreSearchEntry> m_LearnMoreSearchEntries;
+	FString m_LearnMoreSearchPath;
+	FSHAHash m_LearnMoreSearchHash;
+
+	FInstructionScheduler m_InstructionScheduler;
+	FTourState m_ActiveTour;
+	FTourState m_StagingTour;
+	bool m_IsTourStaged = false;
+	int32 m_StagingGeneration = 0;
+	TWeakPtr<FGameDataPipeline> m_StagingPipeline;
+	FQuizQuestionBank m_QuizQuestionBank;
+	uint32 m_CurrentQuizQuestionKey = 0;
+
+	TArray<int32> m_LearnMoreIds;
+	FVisitorSessionState m_SessionState;
+	FVisitorSessionStore m_SessionStore;
+	FJsonParseCache m_ParseCache;
+	FResolvedReferenceTable m_ResolvedReferences;
+	bool m_UseResolvedReferences = false;
+	TAssetNameResolver<USoundBase> m_SoundNameResolver;
+	TAssetNameResolver<UTexture2D> m_ImageNameResolver;
+
+	TAssetListPool<USoundBase> m_SoundListPool;
+	TAssetListPool<UTexture2D> m_ImageListPool;
+	TMap<Instructions, FNarrationAssetLists> m_InstructionAssetLists;
+	TArray<FNarrationAssetLists> m_LearnMoreAssetLists;
+	TArray<FNarrationAssetLists> m_QuizTileAssetLists;
+
+	mutable TMap<FString, FGameDataMemoryReport> m_ContentMemory;
+	mutable TArray<TWeakObjectPtr<UProgressBar>> m_CreatedProgressBars;
+	mutable FTourReplayRecorder m_ReplayRecorder;
+
+	TContentLoader<FInstructionsData, FInstructionGameData> m_InstructionsLoader { TEXT("LoadInstructionsData") };
+	TContentLoader<FCheckpointsData, FCheckpointsGameData> m_CheckpointsLoader { TEXT("LoadCheckpointsData") };
+	TContentLoader<FCheckpointsData, FCheckpointsGameData> m_CheckpointsShardedLoader { TEXT("LoadCheckpointsDataSharded") };
+	TContentLoader<FCheckpointsData, bool> m_StagedTourLoader { TEXT("PrepareTourAsync") };
+	TContentLoader<FLearnMoreData, FLearnMoreGameData> m_LearnMoreLoader { TEXT("PopulateLearnMoreUI") };
+	TContentLoader<FQuizQuestions, FQuizQuestions> m_QuizQuestionsLoader { TEXT("LoadQuizQuestions") };
+
+	FContentShards m_ContentShards;
+	FCheckpointsData m_ShardedCheckpoints;
+	FCaptionTimingData m_ShardedTimings;
+	FString m_ShardedPath;
+	TArray<USoundBase*> m_ShardedSounds;
+	TWeakObjectPtr<UWorld> m_ShardedWorld;
+	TArray<AActor*> m_ShardedActors;
+	int m_LearnMoreCheckpointIndex = INDEX_NONE;
+	FOnContentShardChanged m_OnContentShardChanged;
+	FDelegateHandle m_LevelAddedHandle;
+	FDelegateHandle m_LevelRemovedHandle;
+
+	//Declared last so running reads finish before the caches they use go away.
+	FContentRequestScheduler m_ContentRequests;
 };
@@ -0,0 +1,163 @@
+#include "GameDataLatency.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+CSV_DEFINE_CATEGORY(GameData, true);
+
+/*************************************
+Class: FGameDataLatency
+Author: Antoine Plouffe
+
+Description: Session histograms of the latency of the UGameData entry
+points. Averages hide the hitches visitors notice, so every call is kept in
+a logarithmic histogram giving the p50, p95, p99 and max of the session. The
+histograms are keyed by entry point, tour and checkpoint, and merged by entry
+point for the summary and the CSV profiler metadata.
+*************************************/
+
+void FGameDataLatencyHistogram::Record(double Seconds)
+{
+	const double microseconds = FMath::Max(Seconds * 1000000.0, 1.0);
+	const int32 bucket = FMath::Min((int32)(FMath::Log2(microseconds) * BucketsPerOctave), NumBuckets - 1);
+	m_Buckets[bucket]++;
+	m_Count++;
+	m_TotalSeconds += Seconds;
+	m_MaxSeconds = FMath::Max(m_MaxSeconds, Seconds);
+}
+
+void FGameDataLatencyHistogram::Append(const FGameDataLatencyHistogram& Other)
+{
+	for (int32 i = 0; i < NumBuckets; i++)
+	{
+		m_Buckets[i] += Other.m_Buckets[i];
+	}
+	m_Count += Other.m_Count;
+	m_TotalSeconds += Other.m_TotalSeconds;
+	m_MaxSeconds = FMath::Max(m_MaxSeconds, Other.m_MaxSeconds);
+}
+
+//Returns the upper bound of the bucket holding the percentile,
+//never more than the slowest call recorded.
+double FGameDataLatencyHistogram::GetPercentile(float Percentile) const
+{
+	if (m_Count == 0)
+	{
+		return 0.0;
+	}
+
+	const uint32 rank = FMath::Max<uint32>(FMath::CeilToInt(m_Count * Percentile / 100.0f), 1);
+	uint32 count = 0;
+	for (int32 i = 0; i < NumBuckets; i++)
+	{
+		count += m_Buckets[i];
+		if (count >= rank)
+		{
+			const double upperBound = FMath::Pow(2.0, (double)(i + 1) / BucketsPerOctave) / 1000000.0;
+			return FMath::Min(upperBound, m_MaxSeconds);
+		}
+	}
+	return m_MaxSeconds;
+}
+
+FGameDataLatency& FGameDataLatency::Get()
+{
+	static FGameDataLatency instance;
+	return instance;
+}
+
+FGameDataLatency::FGameDataLatency()
+{
+#if CSV_PROFILER
+	FCsvProfiler::Get()->OnCSVProfileEnd().AddRaw(this, &FGameDataLatency::OnCsvProfileEnd);
+#endif
+}
+
+void FGameDataLatency::Record(FName EntryPoint, uint32 TourKey, int32 CheckpointIndex, double Seconds)
+{
+	{
+		FScopeLock lock(&m_Lock);
+		m_Histograms.FindOrAdd({ EntryPoint, TourKey, CheckpointIndex }).Record(Seconds);
+	}
+
+#if CSV_PROFILER
+	FCsvProfiler::RecordCustomStat(EntryPoint, CSV_CATEGORY_INDEX(GameData), (float)(Seconds * 1000.0), ECsvCustomStatOp::Max);
+#endif
+}
+
+void FGameDataLatency::Reset()
+{
+	FScopeLock lock(&m_Lock);
+	m_Histograms.Empty();
+}
+
+TMap<FName, FGameDataLatencyHistogram> FGameDataLatency::GetEntryPointHistograms() const
+{
+	TMap<FName, FGameDataLatencyHistogram> entryPointHistograms;
+	FScopeLock lock(&m_Lock);
+	for (const auto& histogram : m_Histograms)
+	{
+		entryPointHistograms.FindOrAdd(histogram.Key.m_EntryPoint).Append(histogram.Value);
+	}
+	return entryPointHistograms;
+}
+
+//Logs the summary by entry point, then the breakdown by tour and checkpoint.
+void FGameDataLatency::Report(FOutputDevice& Ar) const
+{
+	const auto logHistogram = [&Ar](const FString& Name, const FGameDataLatencyHistogram& Histogram)
+	{
+		Ar.Logf(TEXT("%-48s %7u  p50 %8.3f  p95 %8.3f  p99 %8.3f  max %8.3f ms"), *Name, Histogram.m_Count,
+			Histogram.GetPercentile(50.0f) * 1000.0, Histogram.GetPercentile(95.0f) * 1000.0, Histogram.GetPercentile(99.0f) * 1000.0, Histogram.m_MaxSeconds * 1000.0);
+	};
+
+	Ar.Logf(TEXT("GameData latency by entry point:"));
+	TMap<FName, FGameDataLatencyHistogram> entryPointHistograms = GetEntryPointHistograms();
+	entryPointHistograms.KeySort(FNameLexicalLess());
+	for (const auto& histogram : entryPointHistograms)
+	{
+		logHistogram(histogram.Key.ToString(), histogram.Value);
+	}
+
+	Ar.Logf(TEXT("GameData latency by tour and checkpoint:"));
+	FScopeLock lock(&m_Lock);
+	TArray<FKey> keys;
+	m_Histograms.GetKeys(keys);
+	keys.Sort([](const FKey& A, const FKey& B)
+	{
+		if (A.m_EntryPoint != B.m_EntryPoint) return A.m_EntryPoint.LexicalLess(B.m_EntryPoint);
+		if (A.m_TourKey != B.m_TourKey) return A.m_TourKey < B.m_TourKey;
+		return A.m_CheckpointIndex < B.m_CheckpointIndex;
+	});
+	for (const FKey& key : keys)
+	{
+		logHistogram(FString::Printf(TEXT("%s tour %08x cp %d"), *key.m_EntryPoint.ToString(), key.m_TourKey, key.m_CheckpointIndex), m_Histograms[key]);
+	}
+}
+
+//Writes the percentiles of the session in the metadata of the capture.
+void FGameDataLatency::OnCsvProfileEnd()
+{
+#if CSV_PROFILER
+	for (const auto& histogram : GetEntryPointHistograms())
+	{
+		const FString prefix = TEXT("GameData.") + histogram.Key.ToString();
+		FCsvProfiler::SetMetadata(*(prefix + TEXT(".p50")), *FString::Printf(TEXT("%.3f"), histogram.Value.GetPercentile(50.0f) * 1000.0));
+		FCsvProfiler::SetMetadata(*(prefix + TEXT(".p95")), *FString::Printf(TEXT("%.3f"), histogram.Value.GetPercentile(95.0f) * 1000.0));
+		FCsvProfiler::SetMetadata(*(prefix + TEXT(".p99")), *FString::Printf(TEXT("%.3f"), histogram.Value.GetPercentile(99.0f) * 1000.0));
+		FCsvProfiler::SetMetadata(*(prefix + TEXT(".max")), *FString::Printf(TEXT("%.3f"), histogram.Value.m_MaxSeconds * 1000.0));
+	}
+#endif
+}
+
+static FAutoConsoleCommandWithArgsAndOutputDevice GameDataLatencyReportCommand(
+	TEXT("GameData.LatencyReport"),
+	TEXT("Reports the p50/p95/p99/max latency of the UGameData entry points over the session. Pass Reset to start over."),
+	FConsoleCommandWithArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, FOutputDevice& Ar)
+	{
+		if (Args.Num() > 0 && Args[0] == TEXT("Reset"))
+		{
+			FGameDataLatency::Get().Reset();
+			return;
+		}
+		FGameDataLatency::Get().Report(Ar);
+	}));
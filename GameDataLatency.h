@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SessionState.h"
+
+//Latency histogram with logarithmic buckets, from 1 microsecond to about
+//16 seconds with a precision of 19%. Percentiles are read from the buckets,
+//so recording costs the same whatever the length of the session.
+struct COLDWARPROJECT_API FGameDataLatencyHistogram
+{
+	static constexpr int32 BucketsPerOctave = 4;
+	static constexpr int32 NumBuckets = 24 * BucketsPerOctave;
+
+	uint32 m_Buckets[NumBuckets] = {};
+	uint32 m_Count = 0;
+	double m_TotalSeconds = 0.0;
+	double m_MaxSeconds = 0.0;
+
+	void Record(double Seconds);
+	void Append(const FGameDataLatencyHistogram& Other);
+	double GetPercentile(float Percentile) const;
+	double GetAverage() const { return m_Count > 0 ? m_TotalSeconds / m_Count : 0.0; }
+};
+
+//Latency of the UGameData entry points over the session, by entry point,
+//tour and checkpoint. Reported by the GameData.LatencyReport console command
+//and written to the CSV profiler captures, as a per frame stat of every entry
+//point and as percentiles in the capture metadata.
+class COLDWARPROJECT_API FGameDataLatency
+{
+public:
+	static FGameDataLatency& Get();
+
+	void Record(FName EntryPoint, uint32 TourKey, int32 CheckpointIndex, double Seconds);
+	void Report(FOutputDevice& Ar) const;
+	void Reset();
+
+private:
+	FGameDataLatency();
+	void OnCsvProfileEnd();
+	TMap<FName, FGameDataLatencyHistogram> GetEntryPointHistograms() const;
+
+	struct FKey
+	{
+		FName m_EntryPoint;
+		uint32 m_TourKey;
+		int32 m_CheckpointIndex;
+
+		bool operator==(const FKey& Other) const
+		{
+			return m_EntryPoint == Other.m_EntryPoint && m_TourKey == Other.m_TourKey && m_CheckpointIndex == Other.m_CheckpointIndex;
+		}
+		friend uint32 GetTypeHash(const FKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.m_EntryPoint), HashCombine(Key.m_TourKey, GetTypeHash(Key.m_CheckpointIndex)));
+		}
+	};
+
+	mutable FCriticalSection m_Lock;
+	TMap<FKey, FGameDataLatencyHistogram> m_Histograms;
+};
+
+//Records the time spent in an entry point when it goes out of scope.
+//The tour is read from the session state at that point, so the loads
+//are counted in the tour they load.
+class COLDWARPROJECT_API FGameDataLatencyScope
+{
+public:
+	FGameDataLatencyScope(const TCHAR* EntryPoint, const FVisitorSessionState& SessionState, int32 CheckpointIndex = INDEX_NONE)
+		: m_EntryPoint(EntryPoint), m_SessionState(SessionState), m_CheckpointIndex(CheckpointIndex), m_StartTime(FPlatformTime::Seconds())
+	{
+	}
+
+	~FGameDataLatencyScope()
+	{
+		FGameDataLatency::Get().Record(m_EntryPoint, m_SessionState.m_TourKey, m_CheckpointIndex, FPlatformTime::Seconds() - m_StartTime);
+	}
+
+private:
+	FName m_EntryPoint;
+	const FVisitorSessionState& m_SessionState;
+	int32 m_CheckpointIndex;
+	double m_StartTime;
+};
@@ -0,0 +1,136 @@
+#include "GameDataMemory.h"
+#include "GameData.h"
+#include "Engine/Texture2D.h"
+
+/*************************************
+Struct: FGameDataMemoryReport
+Author: Antoine Plouffe
+
+Description: Memory used by the game data, split in categories: caption
+strings, narration structs, maps, resolved asset lists, indexes built at
+load, widgets created by UGameData and the sounds and textures referenced
+by the content. The loaded content is measured when a loader returns it,
+since UGameData does not keep it, and the caches are measured on demand.
+Allocations made by the loaders are also tagged GameData for LLM.
+*************************************/
+
+LLM_DEFINE_TAG(GameData);
+
+namespace
+{
+	SIZE_T GetStringsSize(const TArray<FString>& Strings)
+	{
+		SIZE_T size = Strings.GetAllocatedSize();
+		for (const FString& string : Strings)
+		{
+			size += string.GetAllocatedSize();
+		}
+		return size;
+	}
+
+	//Measures the members shared by every narration type.
+	template<typename TNarration>
+	void MeasureNarration(FGameDataMemoryReport& Report, const TNarration& Narration)
+	{
+		Report.Add(EGameDataMemoryCategory::NarrationStructs, sizeof(TNarration));
+		Report.Add(EGameDataMemoryCategory::CaptionStrings, Narration.m_TitleKey.GetAllocatedSize() + GetStringsSize(Narration.m_Keys));
+		Report.Add(EGameDataMemoryCategory::AssetLists, Narration.m_EnglishNarrationSounds.GetAllocatedSize() + Narration.m_FrenchNarrationSounds.GetAllocatedSize());
+	}
+
+	void MeasureLearnMoreNarration(FGameDataMemoryReport& Report, const FLearnMoreNarration& Narration)
+	{
+		MeasureNarration(Report, Narration);
+		Report.Add(EGameDataMemoryCategory::CaptionStrings, Narration.m_SourceName.GetAllocatedSize());
+		Report.Add(EGameDataMemoryCategory::AssetLists, Narration.m_Images.GetAllocatedSize());
+	}
+}
+
+void FGameDataMemoryReport::Append(const FGameDataMemoryReport& Other)
+{
+	for (int32 i = 0; i < (int32)EGameDataMemoryCategory::Num; i++)
+	{
+		m_Bytes[i] += Other.m_Bytes[i];
+	}
+}
+
+SIZE_T FGameDataMemoryReport::GetTotal() const
+{
+	SIZE_T total = 0;
+	for (SIZE_T bytes : m_Bytes)
+	{
+		total += bytes;
+	}
+	return total;
+}
+
+void FGameDataMemoryReport::Log(FOutputDevice& Ar, const FString& Title) const
+{
+	Ar.Logf(TEXT("%s: %.1f KB"), *Title, GetTotal() / 1024.0f);
+	for (int32 i = 0; i < (int32)EGameDataMemoryCategory::Num; i++)
+	{
+		Ar.Logf(TEXT("    %-18s %10.1f KB"), GetCategoryName((EGameDataMemoryCategory)i), m_Bytes[i] / 1024.0f);
+	}
+}
+
+void FGameDataMemoryReport::Measure(const FInstructionGameData& Data)
+{
+	Add(EGameDataMemoryCategory::Maps, Data.InstructionKeyMap.GetAllocatedSize());
+	for (const auto& instruction : Data.InstructionKeyMap)
+	{
+		MeasureNarration(*this, instruction.Value);
+	}
+}
+
+void FGameDataMemoryReport::Measure(const FCheckpointsGameData& Data)
+{
+	Add(EGameDataMemoryCategory::Maps, Data.ActorsToFollow.GetAllocatedSize() + Data.ActorFrameMap.GetAllocatedSize() + Data.ActorKeyMap.GetAllocatedSize());
+	for (const auto& checkpoint : Data.ActorKeyMap)
+	{
+		MeasureNarration(*this, checkpoint.Value);
+	}
+}
+
+void FGameDataMemoryReport::Measure(const FLearnMoreGameData& Data)
+{
+	Add(EGameDataMemoryCategory::Maps, Data.LearnMoreData.GetAllocatedSize());
+	for (const FLearnMoreNarration& narration : Data.LearnMoreData)
+	{
+		MeasureLearnMoreNarration(*this, narration);
+	}
+}
+
+void FGameDataMemoryReport::Measure(const FTilesGameData& Data)
+{
+	Add(EGameDataMemoryCategory::Maps, Data.LearnMoreKeyMap.GetAllocatedSize());
+	for (const auto& tile : Data.LearnMoreKeyMap)
+	{
+		MeasureLearnMoreNarration(*this, tile.Value);
+	}
+}
+
+const TCHAR* FGameDataMemoryReport::GetCategoryName(EGameDataMemoryCategory Category)
+{
+	switch (Category)
+	{
+	case EGameDataMemoryCategory::CaptionStrings: return TEXT("Caption strings");
+	case EGameDataMemoryCategory::NarrationStructs: return TEXT("Narration structs");
+	case EGameDataMemoryCategory::Maps: return TEXT("Maps");
+	case EGameDataMemoryCategory::AssetLists: return TEXT("Asset lists");
+	case EGameDataMemoryCategory::Indexes: return TEXT("Indexes");
+	case EGameDataMemoryCategory::Widgets: return TEXT("Widgets");
+	case EGameDataMemoryCategory::Sounds: return TEXT("Sounds");
+	case EGameDataMemoryCategory::Textures: return TEXT("Textures");
+	default: return TEXT("Unknown");
+	}
+}
+
+static FAutoConsoleCommandWithOutputDevice GameDataMemReportCommand(
+	TEXT("GameData.MemReport"),
+	TEXT("Reports the memory used by the loaded tour content, by content file and by category."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		for (TObjectIterator<UGameData> it(RF_ClassDefaultObject); it; ++it)
+		{
+			it->ReportMemory(Ar);
+		}
+	}));
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "JsonHelper.h"
+#include "HAL/LowLevelMemTracker.h"
+
+LLM_DECLARE_TAG_API(GameData, COLDWARPROJECT_API);
+
+enum class EGameDataMemoryCategory : uint8
+{
+	CaptionStrings,
+	NarrationStructs,
+	Maps,
+	AssetLists,
+	Indexes,
+	Widgets,
+	Sounds,
+	Textures,
+	Num
+};
+
+//Bytes used by the game data, by category. Reported by the
+//GameData.MemReport console command to size content against
+//the memory budget of the kiosks.
+struct COLDWARPROJECT_API FGameDataMemoryReport
+{
+	SIZE_T m_Bytes[(int32)EGameDataMemoryCategory::Num] = {};
+
+	void Add(EGameDataMemoryCategory Category, SIZE_T Bytes) { m_Bytes[(int32)Category] += Bytes; }
+	void Append(const FGameDataMemoryReport& Other);
+	SIZE_T GetTotal() const;
+	void Log(FOutputDevice& Ar, const FString& Title) const;
+
+	void Measure(const FInstructionGameData& Data);
+	void Measure(const FCheckpointsGameData& Data);
+	void Measure(const FLearnMoreGameData& Data);
+	void Measure(const FTilesGameData& Data);
+
+	static const TCHAR* GetCategoryName(EGameDataMemoryCategory Category);
+};
@@ -0,0 +1,113 @@
+#include "GameDataPipeline.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+
+/*************************************
+Class: FGameDataPipeline
+Author: Antoine Plouffe
+
+Description: Runs the loading steps of a tour transition in order. Game
+thread steps run back to back in the same frame until a worker step or a
+next frame step is reached; worker steps go to the thread pool and resume
+the sequence on the game thread once done. Each step keeps the pipeline
+alive, and a cancelled pipeline stops before its next step.
+*************************************/
+
+TSharedRef<FGameDataPipeline> FGameDataPipeline::Create()
+{
+	return MakeShareable(new FGameDataPipeline());
+}
+
+FGameDataPipeline& FGameDataPipeline::OnWorker(TUniqueFunction<void()>&& Work)
+{
+	m_Steps.Add({ EStepThread::Worker, MoveTemp(Work), nullptr });
+	return *this;
+}
+
+FGameDataPipeline& FGameDataPipeline::OnGameThread(TUniqueFunction<void()>&& Work)
+{
+	m_Steps.Add({ EStepThread::GameThread, MoveTemp(Work), nullptr });
+	return *this;
+}
+
+FGameDataPipeline& FGameDataPipeline::NextFrame()
+{
+	m_Steps.Add({ EStepThread::NextFrame, nullptr, nullptr });
+	return *this;
+}
+
+//Runs the work on the game thread once per frame, starting this frame,
+//until it returns true. Used to spread a long step over several frames.
+FGameDataPipeline& FGameDataPipeline::OnEachFrame(TUniqueFunction<bool()>&& Work)
+{
+	m_Steps.Add({ EStepThread::EachFrame, nullptr, MoveTemp(Work) });
+	return *this;
+}
+
+//Starts the steps from the game thread. The completion callback is
+//called on the game thread, with false if the pipeline was cancelled.
+void FGameDataPipeline::Start(TUniqueFunction<void(bool)>&& OnComplete)
+{
+	check(IsInGameThread() && !m_IsRunning);
+	m_OnComplete = MoveTemp(OnComplete);
+	m_IsRunning = true;
+	RunSteps();
+}
+
+void FGameDataPipeline::RunSteps()
+{
+	while (m_NextStep < m_Steps.Num())
+	{
+		if (m_IsCancelled)
+		{
+			break;
+		}
+
+		FStep& step = m_Steps[m_NextStep++];
+		switch (step.m_Thread)
+		{
+		case EStepThread::GameThread:
+			step.m_Work();
+			break;
+
+		case EStepThread::Worker:
+			Async(EAsyncExecution::ThreadPool, [pipeline = AsShared(), &step]()
+			{
+				if (!pipeline->m_IsCancelled)
+				{
+					step.m_Work();
+				}
+				AsyncTask(ENamedThreads::GameThread, [pipeline]() { pipeline->RunSteps(); });
+			});
+			return;
+
+		case EStepThread::EachFrame:
+			if (step.m_FrameWork())
+			{
+				break;
+			}
+			//Not done: run the same step again next frame.
+			m_NextStep--;
+			[[fallthrough]];
+
+		case EStepThread::NextFrame:
+			FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([pipeline = AsShared()](float DeltaTime)
+			{
+				pipeline->RunSteps();
+				return false;
+			}));
+			return;
+		}
+	}
+	Complete();
+}
+
+void FGameDataPipeline::Complete()
+{
+	m_IsRunning = false;
+	if (m_OnComplete)
+	{
+		m_OnComplete(!m_IsCancelled);
+		m_OnComplete = nullptr;
+	}
+}
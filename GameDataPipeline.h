@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+//Sequence of loading steps written in the order they run, each step either
+//running on a worker thread, running on the game thread (once, or once per
+//frame until done) or waiting for the next frame. The steps run one after the other without blocking the game
+//thread, which replaces nesting the callbacks of every asynchronous step.
+//
+//	FGameDataPipeline::Create()
+//		->OnWorker([]() { ... read files ... })
+//		.OnGameThread([]() { ... build runtime data ... })
+//		.NextFrame()
+//		.OnGameThread([]() { ... create widgets ... })
+//		.Start(OnComplete);
+class COLDWARPROJECT_API FGameDataPipeline : public TSharedFromThis<FGameDataPipeline>
+{
+public:
+	static TSharedRef<FGameDataPipeline> Create();
+
+	FGameDataPipeline& OnWorker(TUniqueFunction<void()>&& Work);
+	FGameDataPipeline& OnGameThread(TUniqueFunction<void()>&& Work);
+	FGameDataPipeline& NextFrame();
+	FGameDataPipeline& OnEachFrame(TUniqueFunction<bool()>&& Work);
+
+	void Start(TUniqueFunction<void(bool)>&& OnComplete = nullptr);
+	void Cancel() { m_IsCancelled = true; }
+	bool IsRunning() const { return m_IsRunning; }
+
+private:
+	FGameDataPipeline() = default;
+
+	enum class EStepThread : uint8
+	{
+		Worker,
+		GameThread,
+		NextFrame,
+		EachFrame,
+	};
+
+	struct FStep
+	{
+		EStepThread m_Thread;
+		TUniqueFunction<void()> m_Work;
+		TUniqueFunction<bool()> m_FrameWork;
+	};
+
+	void RunSteps();
+	void Complete();
+
+	TArray<FStep> m_Steps;
+	int32 m_NextStep = 0;
+	TUniqueFunction<void(bool)> m_OnComplete;
+	std::atomic<bool> m_IsCancelled { false };
+	bool m_IsRunning = false;
+};
@@ -0,0 +1,527 @@
+#include "GameDataSerialization.h"
+#include "GameData.h"
+#include "Engine/Texture2D.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/SoftObjectPath.h"
+
+/*************************************
+Class: FGameDataSerializer
+Author: Antoine Plouffe
+
+Description: Versioned binary format of FInstructionGameData,
+FCheckpointsGameData, FLearnMoreGameData and FTilesGameData. A record
+starts with a magic number, the format version and the kind of data, then
+holds a list of fields: a tag, the size of the value and the value. Nested
+values (checkpoints, narrations) are fields containing fields. New fields
+get new tags; the version only changes when an existing field changes meaning.
+*************************************/
+
+namespace
+{
+	enum class EGameDataKind : uint8
+	{
+		Instructions = 1,
+		Checkpoints = 2,
+		LearnMore = 3,
+		Tiles = 4,
+	};
+
+	//Tags of the fields. Never reuse or renumber a tag.
+	enum class EFieldTag : uint16
+	{
+		//Narration
+		TitleKey = 1,
+		Keys = 2,
+		EnglishSounds = 3,
+		FrenchSounds = 4,
+		Images = 5,
+		SourceName = 6,
+		CorrespondingCPIndex = 7,
+		ShouldStopCamera = 8,
+		HasLearnMoreOption = 9,
+		HasQuiz = 10,
+		NumOfLearnMoreOptions = 11,
+
+		//Containers
+		Instruction = 100,
+		InstructionType = 101,
+		Checkpoint = 102,
+		CheckpointName = 103,
+		FrameNumber = 104,
+		LearnMore = 105,
+		Tile = 106,
+		TileIndex = 107,
+		Narration = 108,
+	};
+
+	class FTaggedWriter
+	{
+	public:
+		FTaggedWriter(TArray<uint8>& Bytes, EGameDataKind Kind)
+			: m_Ar(Bytes)
+		{
+			uint32 magic = FGameDataSerializer::Magic;
+			uint16 version = FGameDataSerializer::Version;
+			uint8 kind = (uint8)Kind;
+			m_Ar << magic << version << kind;
+		}
+
+		void BeginField(EFieldTag Tag)
+		{
+			uint16 tag = (uint16)Tag;
+			uint32 size = 0;
+			m_Ar << tag;
+			m_FieldStarts.Push(m_Ar.Tell());
+			m_Ar << size;
+		}
+
+		void EndField()
+		{
+			const int64 start = m_FieldStarts.Pop();
+			const int64 end = m_Ar.Tell();
+			uint32 size = uint32(end - start - sizeof(uint32));
+			m_Ar.Seek(start);
+			m_Ar << size;
+			m_Ar.Seek(end);
+		}
+
+		template<typename T>
+		void Field(EFieldTag Tag, T Value)
+		{
+			BeginField(Tag);
+			m_Ar << Value;
+			EndField();
+		}
+
+		template<typename T>
+		void AssetsField(EFieldTag Tag, const TArray<T*>& Assets)
+		{
+			TArray<FString> paths;
+			for (T* asset : Assets)
+			{
+				paths.Add(FSoftObjectPath(asset).ToString());
+			}
+			Field(Tag, paths);
+		}
+
+	private:
+		FMemoryWriter m_Ar;
+		TArray<int64> m_FieldStarts;
+	};
+
+	class FTaggedReader
+	{
+	public:
+		FTaggedReader(const TArray<uint8>& Bytes)
+			: m_Ar(Bytes)
+		{
+		}
+
+		bool ReadHeader(EGameDataKind Kind, FString& infoMessage)
+		{
+			uint32 magic = 0;
+			uint16 version = 0;
+			uint8 kind = 0;
+			m_Ar << magic << version << kind;
+			if (m_Ar.IsError() || magic != FGameDataSerializer::Magic)
+			{
+				infoMessage = FString("Not A Game Data Record");
+				return false;
+			}
+			if (version > FGameDataSerializer::Version)
+			{
+				infoMessage = FString("Game Data Record From A Newer Version");
+				return false;
+			}
+			if (kind != (uint8)Kind)
+			{
+				infoMessage = FString("Game Data Record Of Another Type");
+				return false;
+			}
+			return true;
+		}
+
+		int64 TotalSize() { return m_Ar.TotalSize(); }
+
+		//Reads the header of the next field before End. The caller reads
+		//what it knows and calls EndField to skip the rest.
+		bool NextField(int64 End, EFieldTag& OutTag, int64& OutFieldEnd)
+		{
+			if (m_Ar.IsError() || m_Ar.Tell() + (int64)(sizeof(uint16) + sizeof(uint32)) > End)
+			{
+				return false;
+			}
+			uint16 tag;
+			uint32 size;
+			m_Ar << tag << size;
+			OutTag = (EFieldTag)tag;
+			OutFieldEnd = m_Ar.Tell() + size;
+			return OutFieldEnd <= End;
+		}
+
+		void EndField(int64 FieldEnd)
+		{
+			m_Ar.Seek(FieldEnd);
+		}
+
+		template<typename T>
+		T Read()
+		{
+			T value;
+			m_Ar << value;
+			return value;
+		}
+
+		template<typename T>
+		void ReadInto(T& Value)
+		{
+			m_Ar << Value;
+		}
+
+		//Reads a list of asset paths and finds the assets among the loaded
+		//ones. Nothing is loaded from here, since a record is read on the
+		//game thread: the assets are the narrative sounds and images the
+		//caller already loaded. Returns false if any asset is not loaded,
+		//keeping the ones that were.
+		template<typename T>
+		bool ReadAssets(TArray<T*>& OutAssets, FString& infoMessage)
+		{
+			bool success = true;
+			OutAssets.Empty();
+			for (const FString& path : Read<TArray<FString>>())
+			{
+				if (T* asset = Cast<T>(FSoftObjectPath(path).ResolveObject()))
+				{
+					OutAssets.Add(asset);
+				}
+				else if (!path.IsEmpty())
+				{
+					success = false;
+					infoMessage = FString::Printf(TEXT("Asset Not Loaded %s"), *path);
+				}
+			}
+			return success;
+		}
+
+		bool IsError() const { return m_Ar.IsError(); }
+
+	private:
+		FMemoryReader m_Ar;
+	};
+
+	//Writes the fields shared by every narration type.
+	template<typename TNarration>
+	void WriteNarrationFields(FTaggedWriter& Writer, const TNarration& Narration)
+	{
+		Writer.Field(EFieldTag::TitleKey, Narration.m_TitleKey);
+		Writer.Field(EFieldTag::Keys, Narration.m_Keys);
+		Writer.AssetsField(EFieldTag::EnglishSounds, Narration.m_EnglishNarrationSounds);
+		Writer.AssetsField(EFieldTag::FrenchSounds, Narration.m_FrenchNarrationSounds);
+	}
+
+	//Reads a field shared by every narration type.
+	//Returns false if the tag is not one of them.
+	template<typename TNarration>
+	bool ReadNarrationField(FTaggedReader& Reader, EFieldTag Tag, TNarration& Narration, bool& success, FString& infoMessage)
+	{
+		switch (Tag)
+		{
+		case EFieldTag::TitleKey: Reader.ReadInto(Narration.m_TitleKey); return true;
+		case EFieldTag::Keys: Reader.ReadInto(Narration.m_Keys); return true;
+		case EFieldTag::EnglishSounds: success &= Reader.ReadAssets(Narration.m_EnglishNarrationSounds, infoMessage); return true;
+		case EFieldTag::FrenchSounds: success &= Reader.ReadAssets(Narration.m_FrenchNarrationSounds, infoMessage); return true;
+		default: return false;
+		}
+	}
+
+	void WriteLearnMoreNarration(FTaggedWriter& Writer, const FLearnMoreNarration& Narration)
+	{
+		WriteNarrationFields(Writer, Narration);
+		Writer.AssetsField(EFieldTag::Images, Narration.m_Images);
+		Writer.Field(EFieldTag::SourceName, Narration.m_SourceName);
+		Writer.Field(EFieldTag::CorrespondingCPIndex, Narration.CorrespondingCPIndex);
+	}
+
+	FLearnMoreNarration ReadLearnMoreNarration(FTaggedReader& Reader, int64 End, bool& success, FString& infoMessage)
+	{
+		FLearnMoreNarration narration;
+		EFieldTag tag;
+		int64 fieldEnd;
+		while (Reader.NextField(End, tag, fieldEnd))
+		{
+			if (!ReadNarrationField(Reader, tag, narration, success, infoMessage))
+			{
+				switch (tag)
+				{
+				case EFieldTag::Images: success &= Reader.ReadAssets(narration.m_Images, infoMessage); break;
+				case EFieldTag::SourceName: Reader.ReadInto(narration.m_SourceName); break;
+				case EFieldTag::CorrespondingCPIndex: Reader.ReadInto(narration.CorrespondingCPIndex); break;
+				default: break;
+				}
+			}
+			Reader.EndField(fieldEnd);
+		}
+		return narration;
+	}
+}
+
+TArray<uint8> FGameDataSerializer::Save(const FInstructionGameData& Data)
+{
+	TArray<uint8> bytes;
+	FTaggedWriter writer(bytes, EGameDataKind::Instructions);
+	for (const auto& instruction : Data.InstructionKeyMap)
+	{
+		writer.BeginField(EFieldTag::Instruction);
+		writer.Field(EFieldTag::InstructionType, (int32)instruction.Key);
+		WriteNarrationFields(writer, instruction.Value);
+		writer.EndField();
+	}
+	return bytes;
+}
+
+TArray<uint8> FGameDataSerializer::Save(const FCheckpointsGameData& Data)
+{
+	TArray<uint8> bytes;
+	FTaggedWriter writer(bytes, EGameDataKind::Checkpoints);
+	for (AActor* actor : Data.ActorsToFollow)
+	{
+		writer.BeginField(EFieldTag::Checkpoint);
+		writer.Field(EFieldTag::CheckpointName, actor && actor->Tags.Num() > 0 ? actor->Tags[0].ToString() : FString());
+		if (const auto* frameNumber = Data.ActorFrameMap.Find(actor))
+		{
+			writer.Field(EFieldTag::FrameNumber, *frameNumber);
+		}
+		if (const FNarrationKeys* narrationKeys = Data.ActorKeyMap.Find(actor))
+		{
+			writer.BeginField(EFieldTag::Narration);
+			WriteNarrationFields(writer, *narrationKeys);
+			writer.Field(EFieldTag::ShouldStopCamera, narrationKeys->m_ShouldStopCamera);
+			writer.Field(EFieldTag::HasLearnMoreOption, narrationKeys->m_HasLearnMoreOption);
+			writer.Field(EFieldTag::HasQuiz, narrationKeys->m_HasQuiz);
+			writer.Field(EFieldTag::NumOfLearnMoreOptions, narrationKeys->m_NumOfLearnMoreOptions);
+			writer.EndField();
+		}
+		writer.EndField();
+	}
+	return bytes;
+}
+
+TArray<uint8> FGameDataSerializer::Save(const FLearnMoreGameData& Data)
+{
+	TArray<uint8> bytes;
+	FTaggedWriter writer(bytes, EGameDataKind::LearnMore);
+	for (const FLearnMoreNarration& narration : Data.LearnMoreData)
+	{
+		writer.BeginField(EFieldTag::LearnMore);
+		WriteLearnMoreNarration(writer, narration);
+		writer.EndField();
+	}
+	return bytes;
+}
+
+TArray<uint8> FGameDataSerializer::Save(const FTilesGameData& Data)
+{
+	TArray<uint8> bytes;
+	FTaggedWriter writer(bytes, EGameDataKind::Tiles);
+	for (const auto& tile : Data.LearnMoreKeyMap)
+	{
+		writer.BeginField(EFieldTag::Tile);
+		writer.Field(EFieldTag::TileIndex, (int32)tile.Key);
+		writer.BeginField(EFieldTag::Narration);
+		WriteLearnMoreNarration(writer, tile.Value);
+		writer.EndField();
+		writer.EndField();
+	}
+	return bytes;
+}
+
+//Reads instructions. Returns false if the record is unreadable or
+//if some sounds could not be found, the rest being loaded anyway.
+bool FGameDataSerializer::Load(const TArray<uint8>& Bytes, FInstructionGameData& OutData, FString& infoMessage)
+{
+	FTaggedReader reader(Bytes);
+	if (!reader.ReadHeader(EGameDataKind::Instructions, infoMessage))
+	{
+		return false;
+	}
+
+	bool success = true;
+	EFieldTag tag;
+	int64 fieldEnd;
+	while (reader.NextField(reader.TotalSize(), tag, fieldEnd))
+	{
+		if (tag == EFieldTag::Instruction)
+		{
+			int32 instructionType = INDEX_NONE;
+			FInstructionNarration narration;
+			EFieldTag innerTag;
+			int64 innerEnd;
+			while (reader.NextField(fieldEnd, innerTag, innerEnd))
+			{
+				if (!ReadNarrationField(reader, innerTag, narration, success, infoMessage) && innerTag == EFieldTag::InstructionType)
+				{
+					reader.ReadInto(instructionType);
+				}
+				reader.EndField(innerEnd);
+			}
+			if (instructionType != INDEX_NONE)
+			{
+				OutData.InstructionKeyMap.Add((Instructions)instructionType, narration);
+			}
+		}
+		reader.EndField(fieldEnd);
+	}
+
+	if (reader.IsError())
+	{
+		infoMessage = FString("Game Data Record Truncated");
+		return false;
+	}
+	return success;
+}
+
+//Reads checkpoints. The checkpoint actors are found by name among
+//CPActors, the same way LoadCheckpointsData does. A checkpoint whose actor
+//is not found keeps its null entry in ActorsToFollow, but no null key is
+//added to the maps for it.
+bool FGameDataSerializer::Load(const TArray<uint8>& Bytes, FCheckpointsGameData& OutData, const TArray<AActor*>& CPActors, UWorld* World, FString& infoMessage)
+{
+	FTaggedReader reader(Bytes);
+	if (!reader.ReadHeader(EGameDataKind::Checkpoints, infoMessage))
+	{
+		return false;
+	}
+
+	bool success = true;
+	EFieldTag tag;
+	int64 fieldEnd;
+	while (reader.NextField(reader.TotalSize(), tag, fieldEnd))
+	{
+		if (tag == EFieldTag::Checkpoint)
+		{
+			AActor* actor = nullptr;
+			EFieldTag innerTag;
+			int64 innerEnd;
+			while (reader.NextField(fieldEnd, innerTag, innerEnd))
+			{
+				if (innerTag == EFieldTag::CheckpointName)
+				{
+					bool found;
+					actor = UGameData::GetActorByName(reader.Read<FString>(), CPActors, World, found, infoMessage);
+					success &= found;
+					OutData.ActorsToFollow.Add(actor);
+				}
+				else if (innerTag == EFieldTag::FrameNumber && actor)
+				{
+					reader.ReadInto(OutData.ActorFrameMap.FindOrAdd(actor));
+				}
+				else if (innerTag == EFieldTag::Narration && actor)
+				{
+					FNarrationKeys narrationKeys;
+					EFieldTag narrationTag;
+					int64 narrationEnd;
+					while (reader.NextField(innerEnd, narrationTag, narrationEnd))
+					{
+						if (!ReadNarrationField(reader, narrationTag, narrationKeys, success, infoMessage))
+						{
+							switch (narrationTag)
+							{
+							case EFieldTag::ShouldStopCamera: reader.ReadInto(narrationKeys.m_ShouldStopCamera); break;
+							case EFieldTag::HasLearnMoreOption: reader.ReadInto(narrationKeys.m_HasLearnMoreOption); break;
+							case EFieldTag::HasQuiz: reader.ReadInto(narrationKeys.m_HasQuiz); break;
+							case EFieldTag::NumOfLearnMoreOptions: reader.ReadInto(narrationKeys.m_NumOfLearnMoreOptions); break;
+							default: break;
+							}
+						}
+						reader.EndField(narrationEnd);
+					}
+					OutData.ActorKeyMap.Add(actor, narrationKeys);
+				}
+				reader.EndField(innerEnd);
+			}
+		}
+		reader.EndField(fieldEnd);
+	}
+
+	if (reader.IsError())
+	{
+		infoMessage = FString("Game Data Record Truncated");
+		return false;
+	}
+	return success;
+}
+
+//Reads learn more entries. Returns false if the record is unreadable or
+//if some assets could not be found, the rest being loaded anyway.
+bool FGameDataSerializer::Load(const TArray<uint8>& Bytes, FLearnMoreGameData& OutData, FString& infoMessage)
+{
+	FTaggedReader reader(Bytes);
+	if (!reader.ReadHeader(EGameDataKind::LearnMore, infoMessage))
+	{
+		return false;
+	}
+
+	bool success = true;
+	EFieldTag tag;
+	int64 fieldEnd;
+	while (reader.NextField(reader.TotalSize(), tag, fieldEnd))
+	{
+		if (tag == EFieldTag::LearnMore)
+		{
+			OutData.LearnMoreData.Add(ReadLearnMoreNarration(reader, fieldEnd, success, infoMessage));
+		}
+		reader.EndField(fieldEnd);
+	}
+
+	if (reader.IsError())
+	{
+		infoMessage = FString("Game Data Record Truncated");
+		return false;
+	}
+	return success;
+}
+
+//Reads quiz tiles. Returns false if the record is unreadable or
+//if some assets could not be found, the rest being loaded anyway.
+bool FGameDataSerializer::Load(const TArray<uint8>& Bytes, FTilesGameData& OutData, FString& infoMessage)
+{
+	FTaggedReader reader(Bytes);
+	if (!reader.ReadHeader(EGameDataKind::Tiles, infoMessage))
+	{
+		return false;
+	}
+
+	bool success = true;
+	EFieldTag tag;
+	int64 fieldEnd;
+	while (reader.NextField(reader.TotalSize(), tag, fieldEnd))
+	{
+		if (tag == EFieldTag::Tile)
+		{
+			int32 tileIndex = INDEX_NONE;
+			EFieldTag innerTag;
+			int64 innerEnd;
+			while (reader.NextField(fieldEnd, innerTag, innerEnd))
+			{
+				if (innerTag == EFieldTag::TileIndex)
+				{
+					reader.ReadInto(tileIndex);
+				}
+				else if (innerTag == EFieldTag::Narration && tileIndex != INDEX_NONE)
+				{
+					OutData.LearnMoreKeyMap.Add(tileIndex, ReadLearnMoreNarration(reader, innerEnd, success, infoMessage));
+				}
+				reader.EndField(innerEnd);
+			}
+		}
+		reader.EndField(fieldEnd);
+	}
+
+	if (reader.IsError())
+	{
+		infoMessage = FString("Game Data Record Truncated");
+		return false;
+	}
+	return success;
+}
@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "JsonHelper.h"
+
+//Binary serialization of the runtime game data, used for caches, session
+//snapshots and transfers between processes. Every value is written as a
+//tagged field with its size, so a reader skips the fields it does not know
+//and older builds can read data written by newer ones. Assets are stored by
+//path and actors by their checkpoint tag, and resolved again on load.
+class COLDWARPROJECT_API FGameDataSerializer
+{
+public:
+	static constexpr uint32 Magic = 0x54524447; //GDRT
+	static constexpr uint16 Version = 1;
+
+	static TArray<uint8> Save(const FInstructionGameData& Data);
+	static TArray<uint8> Save(const FCheckpointsGameData& Data);
+	static TArray<uint8> Save(const FLearnMoreGameData& Data);
+	static TArray<uint8> Save(const FTilesGameData& Data);
+
+	static bool Load(const TArray<uint8>& Bytes, FInstructionGameData& OutData, FString& infoMessage);
+	static bool Load(const TArray<uint8>& Bytes, FCheckpointsGameData& OutData, const TArray<AActor*>& CPActors, UWorld* World, FString& infoMessage);
+	static bool Load(const TArray<uint8>& Bytes, FLearnMoreGameData& OutData, FString& infoMessage);
+	static bool Load(const TArray<uint8>& Bytes, FTilesGameData& OutData, FString& infoMessage);
+};
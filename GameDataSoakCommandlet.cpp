@@ -0,0 +1,379 @@
+#include "GameDataSoakCommandlet.h"
+#include "GameData.h"
+#include "GameDataSerialization.h"
+#include "Components/HorizontalBox.h"
+#include "Engine/Texture2D.h"
+#include "HAL/PlatformMemory.h"
+#include "JsonObjectConverter.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Sound/SoundWave.h"
+#include "UObject/UObjectArray.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGameDataSoak, Log, All);
+
+/*************************************
+Class: UGameDataSoakCommandlet
+Author: Antoine Plouffe
+
+Description: Headless soak of the loaders and UI helpers of UGameData, to
+catch what accumulates over the weeks a kiosk runs. The content is written
+to the Saved directory from the same structs the JSON files are read into,
+and the checkpoints, sounds and images are transient objects named like the
+real ones. Garbage is collected at the end of every iteration, as a level
+change would, and the heap and UObject count are sampled right after.
+*************************************/
+
+namespace
+{
+	struct FSoakContent
+	{
+		FString m_InstructionsPath;
+		FString m_CheckpointsPath;
+		FString m_LearnMorePath;
+		FQuizQuestions m_QuizQuestions;
+		TArray<USoundBase*> m_Sounds;
+		TArray<UTexture2D*> m_Images;
+		TArray<AActor*> m_Checkpoints;
+	};
+
+	template<typename TStruct>
+	bool WriteContentFile(const TStruct& Data, const FString& Path)
+	{
+		FString jsonString;
+		return FJsonObjectConverter::UStructToJsonObjectString(Data, jsonString) && FFileHelper::SaveStringToFile(jsonString, *Path);
+	}
+
+	//Rooted so the garbage collection of the iterations keeps them.
+	template<typename T>
+	T* NewSoakObject(const FString& Name)
+	{
+		T* object = NewObject<T>(GetTransientPackage(), FName(*Name));
+		object->AddToRoot();
+		return object;
+	}
+
+	FString GetSoundName(int32 Index)
+	{
+		return FString::Printf(TEXT("SoakSound_%d"), Index);
+	}
+
+	bool CreateSoakContent(int32 NumCheckpoints, int32 NumLearnMorePerCheckpoint, int32 NumQuestions, FSoakContent& OutContent)
+	{
+		const FString contentDir = FPaths::ProjectSavedDir() / TEXT("GameDataSoak");
+		OutContent.m_InstructionsPath = contentDir / TEXT("instructions.json");
+		OutContent.m_CheckpointsPath = contentDir / TEXT("checkpoints.json");
+		OutContent.m_LearnMorePath = contentDir / TEXT("learnMore.json");
+		int32 numSounds = 0;
+		int32 numImages = 0;
+
+		FInstructionsData instructions;
+		static const TCHAR* InstructionTypes[] = { TEXT("LearnMoreProposed"), TEXT("LearnMoreCompleted"), TEXT("HowToSelection"), TEXT("QuizProposed"),
+			TEXT("LearnMoreNavigation"), TEXT("MiniGameQuiz_Context"), TEXT("MiniGameQuiz_QuestionInstruction"), TEXT("Inactivity_Instruction") };
+		for (const TCHAR* instructionType : InstructionTypes)
+		{
+			auto& entry = instructions.Data.AddDefaulted_GetRef();
+			entry.InstructionType = instructionType;
+			entry.TitleCaptionKey = FString::Printf(TEXT("%s_Title"), instructionType);
+			entry.CaptionKeys.Add(FString::Printf(TEXT("%s_Caption"), instructionType));
+			entry.EnglishNarrationSoundNames.Add(GetSoundName(numSounds++));
+			entry.FrenchNarrationSoundNames.Add(GetSoundName(numSounds++));
+		}
+
+		FCheckpointsData checkpoints;
+		FLearnMoreData learnMore;
+		for (int i = 0; i < NumCheckpoints; i++)
+		{
+			const FString checkpointName = FString::Printf(TEXT("SoakCheckpoint_%d"), i);
+			AActor* checkpoint = NewSoakObject<AActor>(checkpointName);
+			checkpoint->Tags.Add(FName(*checkpointName));
+			OutContent.m_Checkpoints.Add(checkpoint);
+
+			auto& entry = checkpoints.Data.AddDefaulted_GetRef();
+			entry.CheckpointName = checkpointName;
+			entry.CheckpointFrameNumber = i * 300;
+			entry.TitleCaptionKey = checkpointName + TEXT("_Title");
+			entry.CaptionKeys.Add(checkpointName + TEXT("_Caption_0"));
+			entry.CaptionKeys.Add(checkpointName + TEXT("_Caption_1"));
+			entry.EnglishNarrationSoundNames.Add(GetSoundName(numSounds++));
+			entry.FrenchNarrationSoundNames.Add(GetSoundName(numSounds++));
+			entry.ShouldStopCamera = NumLearnMorePerCheckpoint > 0;
+			entry.HasLearnMoreOption = NumLearnMorePerCheckpoint > 0;
+			entry.HasQuiz = i == NumCheckpoints - 1;
+			entry.NumOfLearnMoreOption = NumLearnMorePerCheckpoint;
+
+			for (int j = 0; j < NumLearnMorePerCheckpoint; j++)
+			{
+				auto& learnMoreEntry = learnMore.Data.AddDefaulted_GetRef();
+				learnMoreEntry.CorrespondingCPIndex = i;
+				learnMoreEntry.TitleCaptionKey = FString::Printf(TEXT("%s_LearnMore_%d_Title"), *checkpointName, j);
+				learnMoreEntry.CaptionKeys.Add(FString::Printf(TEXT("%s_LearnMore_%d_Caption"), *checkpointName, j));
+				learnMoreEntry.EnglishNarrationSoundNames.Add(GetSoundName(numSounds++));
+				learnMoreEntry.FrenchNarrationSoundNames.Add(GetSoundName(numSounds++));
+				learnMoreEntry.ImagesNames.Add(FString::Printf(TEXT("SoakImage_%d"), numImages++));
+				learnMoreEntry.ImagesSources.Add(TEXT("Soak"));
+			}
+		}
+
+		for (int i = 0; i < NumQuestions; i++)
+		{
+			auto& question = OutContent.m_QuizQuestions.m_Questions.AddDefaulted_GetRef();
+			for (int j = 0; j < 4; j++)
+			{
+				auto& option = question.QuestionOptions.Options.AddDefaulted_GetRef();
+				option.OptionName = FString::Printf(TEXT("SoakQuestion_%d_Option_%d"), i, j);
+				option.OptionDescription = option.OptionName + TEXT("_Description");
+				option.EnglishNarrationSound = GetSoundName(numSounds++);
+				option.FrenchNarrationSound = GetSoundName(numSounds++);
+			}
+		}
+
+		for (int i = 0; i < numSounds; i++)
+		{
+			OutContent.m_Sounds.Add(NewSoakObject<USoundWave>(GetSoundName(i)));
+		}
+		for (int i = 0; i < numImages; i++)
+		{
+			OutContent.m_Images.Add(NewSoakObject<UTexture2D>(FString::Printf(TEXT("SoakImage_%d"), i)));
+		}
+
+		return WriteContentFile(instructions, OutContent.m_InstructionsPath)
+			&& WriteContentFile(checkpoints, OutContent.m_CheckpointsPath)
+			&& WriteContentFile(learnMore, OutContent.m_LearnMorePath);
+	}
+
+	//Goes through the whole tour once, like a visitor seeing everything.
+	void RunTour(UGameData* GameData, UHorizontalBox* ProgressBarsBox, const FSoakContent& Content)
+	{
+		GameData->LoadInstructionsData(nullptr, Content.m_InstructionsPath, Content.m_Sounds);
+		const FCheckpointsGameData checkpoints = GameData->LoadCheckpointsData(nullptr, Content.m_CheckpointsPath, Content.m_Sounds, Content.m_Checkpoints);
+
+		for (int i = 0; i < checkpoints.ActorsToFollow.Num(); i++)
+		{
+			const FNarrationKeys* narrationKeys = checkpoints.ActorKeyMap.Find(checkpoints.ActorsToFollow[i]);
+			if (!narrationKeys || !narrationKeys->m_HasLearnMoreOption)
+			{
+				continue;
+			}
+
+			const FLearnMoreGameData learnMore = GameData->PopulateLearnMoreUI(Content.m_LearnMorePath, i, Content.m_Sounds, Content.m_Images);
+			ProgressBarsBox->ClearChildren();
+			GameData->LoadLearnMoreProgressBar(ProgressBarsBox, FProgressBarStyle(), narrationKeys->m_NumOfLearnMoreOptions);
+			for (int j = 0; j < learnMore.LearnMoreData.Num(); j++)
+			{
+				GameData->MarkLearnMoreCompleted(j);
+			}
+		}
+
+		for (int i = 0; i < Content.m_QuizQuestions.m_Questions.Num(); i++)
+		{
+			GameData->PopulateQuizUI(Content.m_Sounds, Content.m_QuizQuestions, i);
+			GameData->MarkQuizAnswered(i, 0);
+		}
+	}
+
+	//Compares the narration fields every narration type serializes.
+	template<typename TNarration>
+	bool IsSameNarration(const TNarration& A, const TNarration& B)
+	{
+		return A.m_TitleKey == B.m_TitleKey && A.m_Keys == B.m_Keys
+			&& A.m_EnglishNarrationSounds == B.m_EnglishNarrationSounds && A.m_FrenchNarrationSounds == B.m_FrenchNarrationSounds;
+	}
+
+	//Saves the loaded content with FGameDataSerializer and loads it back,
+	//which must give the same data. A checkpoint whose actor is not found
+	//must fail the load without adding a null actor to the maps.
+	bool CheckSerializationRoundTrip(UGameData* GameData, const FSoakContent& Content)
+	{
+		FString message;
+		const FInstructionGameData instructions = GameData->LoadInstructionsData(nullptr, Content.m_InstructionsPath, Content.m_Sounds);
+		FInstructionGameData loadedInstructions;
+		bool isSame = FGameDataSerializer::Load(FGameDataSerializer::Save(instructions), loadedInstructions, message)
+			&& loadedInstructions.InstructionKeyMap.Num() == instructions.InstructionKeyMap.Num();
+		for (const auto& instruction : instructions.InstructionKeyMap)
+		{
+			const FInstructionNarration* loaded = loadedInstructions.InstructionKeyMap.Find(instruction.Key);
+			isSame &= loaded && IsSameNarration(instruction.Value, *loaded);
+		}
+		if (!isSame)
+		{
+			UE_LOG(LogGameDataSoak, Error, TEXT("Instructions Round Trip Mismatch %s"), *message);
+			return false;
+		}
+
+		const FCheckpointsGameData checkpoints = GameData->LoadCheckpointsData(nullptr, Content.m_CheckpointsPath, Content.m_Sounds, Content.m_Checkpoints);
+		const TArray<uint8> checkpointBytes = FGameDataSerializer::Save(checkpoints);
+		FCheckpointsGameData loadedCheckpoints;
+		isSame = FGameDataSerializer::Load(checkpointBytes, loadedCheckpoints, Content.m_Checkpoints, nullptr, message)
+			&& loadedCheckpoints.ActorsToFollow == checkpoints.ActorsToFollow
+			&& loadedCheckpoints.ActorFrameMap.OrderIndependentCompareEqual(checkpoints.ActorFrameMap)
+			&& loadedCheckpoints.ActorKeyMap.Num() == checkpoints.ActorKeyMap.Num();
+		for (const auto& narration : checkpoints.ActorKeyMap)
+		{
+			const FNarrationKeys* loaded = loadedCheckpoints.ActorKeyMap.Find(narration.Key);
+			isSame &= loaded && IsSameNarration(narration.Value, *loaded)
+				&& loaded->m_ShouldStopCamera == narration.Value.m_ShouldStopCamera && loaded->m_HasLearnMoreOption == narration.Value.m_HasLearnMoreOption
+				&& loaded->m_HasQuiz == narration.Value.m_HasQuiz && loaded->m_NumOfLearnMoreOptions == narration.Value.m_NumOfLearnMoreOptions;
+		}
+		if (!isSame)
+		{
+			UE_LOG(LogGameDataSoak, Error, TEXT("Checkpoints Round Trip Mismatch %s"), *message);
+			return false;
+		}
+
+		if (Content.m_Checkpoints.Num() > 0)
+		{
+			TArray<AActor*> missingLast = Content.m_Checkpoints;
+			missingLast.Pop();
+			FCheckpointsGameData partialCheckpoints;
+			if (FGameDataSerializer::Load(checkpointBytes, partialCheckpoints, missingLast, nullptr, message)
+				|| partialCheckpoints.ActorFrameMap.Contains(nullptr) || partialCheckpoints.ActorKeyMap.Contains(nullptr))
+			{
+				UE_LOG(LogGameDataSoak, Error, TEXT("Checkpoints Round Trip Kept A Missing Actor"));
+				return false;
+			}
+		}
+
+		const FLearnMoreGameData learnMore = GameData->PopulateLearnMoreUI(Content.m_LearnMorePath, 0, Content.m_Sounds, Content.m_Images);
+		FLearnMoreGameData loadedLearnMore;
+		isSame = FGameDataSerializer::Load(FGameDataSerializer::Save(learnMore), loadedLearnMore, message)
+			&& loadedLearnMore.LearnMoreData.Num() == learnMore.LearnMoreData.Num();
+		for (int i = 0; isSame && i < learnMore.LearnMoreData.Num(); i++)
+		{
+			const FLearnMoreNarration& narration = learnMore.LearnMoreData[i];
+			const FLearnMoreNarration& loaded = loadedLearnMore.LearnMoreData[i];
+			isSame = IsSameNarration(narration, loaded) && loaded.m_Images == narration.m_Images
+				&& loaded.m_SourceName == narration.m_SourceName && loaded.CorrespondingCPIndex == narration.CorrespondingCPIndex;
+		}
+		if (!isSame)
+		{
+			UE_LOG(LogGameDataSoak, Error, TEXT("Learn More Round Trip Mismatch %s"), *message);
+			return false;
+		}
+		return true;
+	}
+
+	struct FSoakSample
+	{
+		uint64 m_UsedPhysical = 0;
+		int32 m_NumObjects = 0;
+	};
+
+	FSoakSample TakeSample()
+	{
+		FSoakSample sample;
+		sample.m_UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+		sample.m_NumObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+		return sample;
+	}
+
+	double GetAverage(const TArray<double>& Values, int32 First, int32 Num)
+	{
+		double total = 0.0;
+		for (int i = First; i < First + Num; i++)
+		{
+			total += Values[i];
+		}
+		return Num > 0 ? total / Num : 0.0;
+	}
+}
+
+UGameDataSoakCommandlet::UGameDataSoakCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UGameDataSoakCommandlet::Main(const FString& Params)
+{
+	int32 iterations = 5000;
+	int32 warmup = 100;
+	int32 numCheckpoints = 20;
+	int32 numLearnMorePerCheckpoint = 3;
+	int32 numQuestions = 10;
+	float maxHeapGrowthMB = 16.0f;
+	int32 maxObjectGrowth = 100;
+	float maxTimeGrowth = 1.5f;
+	FParse::Value(*Params, TEXT("Iterations="), iterations);
+	FParse::Value(*Params, TEXT("Warmup="), warmup);
+	FParse::Value(*Params, TEXT("Checkpoints="), numCheckpoints);
+	FParse::Value(*Params, TEXT("LearnMorePerCheckpoint="), numLearnMorePerCheckpoint);
+	FParse::Value(*Params, TEXT("Questions="), numQuestions);
+	FParse::Value(*Params, TEXT("MaxHeapGrowthMB="), maxHeapGrowthMB);
+	FParse::Value(*Params, TEXT("MaxObjectGrowth="), maxObjectGrowth);
+	FParse::Value(*Params, TEXT("MaxTimeGrowth="), maxTimeGrowth);
+	warmup = FMath::Clamp(warmup, 1, FMath::Max(iterations - 1, 1));
+
+	FSoakContent content;
+	if (!CreateSoakContent(numCheckpoints, numLearnMorePerCheckpoint, numQuestions, content))
+	{
+		UE_LOG(LogGameDataSoak, Error, TEXT("Could not write the soak content to %s"), *FPaths::GetPath(content.m_InstructionsPath));
+		return 1;
+	}
+
+	UGameData* gameData = NewObject<UGameData>();
+	gameData->AddToRoot();
+	gameData->GameData();
+	UHorizontalBox* progressBarsBox = NewObject<UHorizontalBox>();
+	progressBarsBox->AddToRoot();
+	const bool isRoundTripSame = CheckSerializationRoundTrip(gameData, content);
+
+	TArray<double> iterationTimes;
+	iterationTimes.Reserve(iterations);
+	FSoakSample baseline;
+	FSoakSample last;
+	for (int i = 0; i < iterations; i++)
+	{
+		const double startTime = FPlatformTime::Seconds();
+		RunTour(gameData, progressBarsBox, content);
+		iterationTimes.Add(FPlatformTime::Seconds() - startTime);
+
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		last = TakeSample();
+		if (i == warmup - 1)
+		{
+			baseline = last;
+		}
+		if ((i + 1) % 500 == 0)
+		{
+			UE_LOG(LogGameDataSoak, Display, TEXT("%d/%d: %.1f MB, %d objects, %.3f ms"), i + 1, iterations,
+				last.m_UsedPhysical / (1024.0 * 1024.0), last.m_NumObjects, iterationTimes.Last() * 1000.0);
+		}
+	}
+
+	//The iteration time is compared between the first and the last window
+	//after the warmup, so a single slow iteration does not fail the soak.
+	const int32 window = FMath::Max((iterations - warmup) / 10, 1);
+	const double firstTime = GetAverage(iterationTimes, warmup, FMath::Min(window, iterations - warmup));
+	const double lastTime = GetAverage(iterationTimes, FMath::Max(iterations - window, warmup), FMath::Min(window, iterations - warmup));
+	const double heapGrowthMB = ((int64)last.m_UsedPhysical - (int64)baseline.m_UsedPhysical) / (1024.0 * 1024.0);
+	const int32 objectGrowth = last.m_NumObjects - baseline.m_NumObjects;
+	const double timeGrowth = firstTime > 0.0 ? lastTime / firstTime : 1.0;
+
+	UE_LOG(LogGameDataSoak, Display, TEXT("Heap growth %.2f MB (max %.2f), object growth %d (max %d), time %.3f ms -> %.3f ms (x%.2f, max x%.2f)"),
+		heapGrowthMB, maxHeapGrowthMB, objectGrowth, maxObjectGrowth, firstTime * 1000.0, lastTime * 1000.0, timeGrowth, maxTimeGrowth);
+	gameData->ReportMemory(*GLog);
+
+	int32 result = isRoundTripSame ? 0 : 1;
+	if (heapGrowthMB > maxHeapGrowthMB)
+	{
+		UE_LOG(LogGameDataSoak, Error, TEXT("Heap Grew By %.2f MB"), heapGrowthMB);
+		result = 1;
+	}
+	if (objectGrowth > maxObjectGrowth)
+	{
+		UE_LOG(LogGameDataSoak, Error, TEXT("UObject Count Grew By %d"), objectGrowth);
+		result = 1;
+	}
+	if (timeGrowth > maxTimeGrowth)
+	{
+		UE_LOG(LogGameDataSoak, Error, TEXT("Iteration Time Grew By x%.2f"), timeGrowth);
+		result = 1;
+	}
+
+	progressBarsBox->RemoveFromRoot();
+	gameData->RemoveFromRoot();
+	return result;
+}
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "GameDataSoakCommandlet.generated.h"
+
+//Soaks UGameData with synthetic content: every iteration loads the tour,
+//then goes through all the checkpoints, learn more panels and quiz questions
+//like a visitor would. Fails when the heap, the UObject count or the
+//iteration time keep growing past the given thresholds after the warmup,
+//or when the loaded content does not survive a save/load round trip
+//through FGameDataSerializer.
+//
+//Usage: UnrealEditor-Cmd ColdWarProject -run=GameDataSoak -nullrhi
+//	[-Iterations=5000] [-Warmup=100] [-Checkpoints=20] [-LearnMorePerCheckpoint=3]
+//	[-Questions=10] [-MaxHeapGrowthMB=16] [-MaxObjectGrowth=100] [-MaxTimeGrowth=1.5]
+UCLASS()
+class COLDWARPROJECT_API UGameDataSoakCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UGameDataSoakCommandlet();
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,263 @@
+#include "InstructionScheduler.h"
+
+/*************************************
+Class: FInstructionScheduler
+Author: Antoine Plouffe
+
+Description: Schedules the timed instructions of the application in a
+hierarchical timing wheel of 4 levels of 64 slots, ticking every 50ms.
+Triggers expiring within 64 ticks go in the first level, the others wait
+in a coarser level and cascade down as the wheel turns. Triggers are
+pooled in a single array and linked into their slot by index.
+*************************************/
+
+FInstructionScheduler::FInstructionScheduler()
+{
+	for (int32& head : m_SlotHeads)
+	{
+		head = INDEX_NONE;
+	}
+}
+
+//Keeps the loaded instructions so the listeners can get the narration
+//of the triggered instructions. Triggers already pending are kept. The
+//sound lists are left empty by UGameData, which keeps them once in its
+//asset list pool (see UGameData::GetInstructionAssetLists).
+void FInstructionScheduler::SetInstructions(const FInstructionGameData& InstructionData)
+{
+	m_InstructionData = InstructionData;
+}
+
+//Returns the narration of a loaded instruction, or nullptr.
+const FInstructionNarration* FInstructionScheduler::GetNarration(Instructions Instruction) const
+{
+	return m_InstructionData.InstructionKeyMap.Find(Instruction);
+}
+
+//Schedules an instruction to trigger after the given delay in seconds.
+//With a repeat interval, the instruction triggers again until cancelled.
+FInstructionTriggerHandle FInstructionScheduler::Schedule(Instructions Instruction, float Delay, float RepeatInterval)
+{
+	int32 triggerIndex;
+	if (m_FreeTriggers.Num() > 0)
+	{
+		triggerIndex = m_FreeTriggers.Pop();
+	}
+	else
+	{
+		triggerIndex = m_Triggers.AddDefaulted();
+	}
+
+	FTrigger& trigger = m_Triggers[triggerIndex];
+	trigger.m_Instruction = Instruction;
+	trigger.m_ExpireTick = m_CurrentTick + FMath::Max<uint64>(SecondsToTicks(Delay), 1);
+	trigger.m_RepeatTicks = RepeatInterval > 0.0f ? (uint32)FMath::Max<uint64>(SecondsToTicks(RepeatInterval), 1) : 0;
+	Insert(triggerIndex);
+	m_NumPending++;
+
+	FInstructionTriggerHandle handle;
+	handle.m_Index = triggerIndex;
+	handle.m_Serial = trigger.m_Serial;
+	handle.m_Instruction = Instruction;
+	handle.m_RepeatInterval = RepeatInterval;
+	return handle;
+}
+
+//Cancels a pending trigger and invalidates the handle. Returns false
+//if the trigger already fired or was cancelled.
+bool FInstructionScheduler::Cancel(FInstructionTriggerHandle& Handle)
+{
+	const bool isPending = Handle.IsValid() && m_Triggers.IsValidIndex(Handle.m_Index)
+		&& m_Triggers[Handle.m_Index].m_Serial == Handle.m_Serial && m_Triggers[Handle.m_Index].m_Slot != INDEX_NONE;
+	if (isPending)
+	{
+		Unlink(Handle.m_Index);
+		Release(Handle.m_Index);
+	}
+	Handle.Invalidate();
+	return isPending;
+}
+
+//Cancels the trigger if still pending and schedules its instruction again
+//with a new delay, keeping its repeat interval. A trigger that already
+//fired or was cancelled is added again. Used by the inactivity prompt,
+//which restarts every time the visitor interacts.
+FInstructionTriggerHandle FInstructionScheduler::Restart(FInstructionTriggerHandle& Handle, float Delay)
+{
+	if (!Handle.m_Instruction.IsSet())
+	{
+		Handle.Invalidate();
+		return Handle;
+	}
+
+	const Instructions instruction = Handle.m_Instruction.GetValue();
+	const float repeatInterval = Handle.m_RepeatInterval;
+	Cancel(Handle);
+	return Schedule(instruction, Delay, repeatInterval);
+}
+
+//Cancels every pending trigger.
+void FInstructionScheduler::CancelAll()
+{
+	for (int i = 0; i < m_Triggers.Num(); i++)
+	{
+		if (m_Triggers[i].m_Slot != INDEX_NONE)
+		{
+			Unlink(i);
+			Release(i);
+		}
+	}
+}
+
+//Turns the wheel by the elapsed time and broadcasts every
+//instruction that triggered in one batch.
+void FInstructionScheduler::Advance(float DeltaTime)
+{
+	m_PendingTime += DeltaTime;
+	TArray<Instructions> fired;
+	while (m_PendingTime >= TickInterval)
+	{
+		m_PendingTime -= TickInterval;
+		m_CurrentTick++;
+		ProcessTick(fired);
+		if (m_NumPending == 0)
+		{
+			m_PendingTime = 0.0f;
+			break;
+		}
+	}
+
+	if (fired.Num() > 0)
+	{
+		m_OnInstructionsTriggered.Broadcast(fired);
+	}
+}
+
+TStatId FInstructionScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FInstructionScheduler, STATGROUP_Tickables);
+}
+
+uint64 FInstructionScheduler::SecondsToTicks(float Seconds)
+{
+	return (uint64)FMath::CeilToInt(FMath::Max(Seconds, 0.0f) / TickInterval);
+}
+
+//Links a trigger into the slot of the level matching how far its
+//expiration is. Triggers further than the wheel range wait in the last
+//level and are placed again when they cascade down.
+void FInstructionScheduler::Insert(int32 TriggerIndex)
+{
+	FTrigger& trigger = m_Triggers[TriggerIndex];
+	const uint64 delta = trigger.m_ExpireTick > m_CurrentTick ? trigger.m_ExpireTick - m_CurrentTick : 0;
+
+	int32 level = 0;
+	while (level < NumLevels - 1 && delta >= (uint64(1) << (SlotBits * (level + 1))))
+	{
+		level++;
+	}
+
+	uint64 expireTick = trigger.m_ExpireTick;
+	if (delta >= (uint64(1) << (SlotBits * NumLevels)))
+	{
+		expireTick = m_CurrentTick + (uint64(1) << (SlotBits * NumLevels)) - 1;
+	}
+
+	const int32 slot = level * SlotsPerLevel + int32((expireTick >> (SlotBits * level)) & SlotMask);
+	trigger.m_Slot = slot;
+	trigger.m_Prev = INDEX_NONE;
+	trigger.m_Next = m_SlotHeads[slot];
+	if (trigger.m_Next != INDEX_NONE)
+	{
+		m_Triggers[trigger.m_Next].m_Prev = TriggerIndex;
+	}
+	m_SlotHeads[slot] = TriggerIndex;
+}
+
+//Removes a trigger from its slot.
+void FInstructionScheduler::Unlink(int32 TriggerIndex)
+{
+	FTrigger& trigger = m_Triggers[TriggerIndex];
+	if (trigger.m_Prev != INDEX_NONE)
+	{
+		m_Triggers[trigger.m_Prev].m_Next = trigger.m_Next;
+	}
+	else
+	{
+		m_SlotHeads[trigger.m_Slot] = trigger.m_Next;
+	}
+	if (trigger.m_Next != INDEX_NONE)
+	{
+		m_Triggers[trigger.m_Next].m_Prev = trigger.m_Prev;
+	}
+	trigger.m_Slot = INDEX_NONE;
+	trigger.m_Prev = INDEX_NONE;
+	trigger.m_Next = INDEX_NONE;
+}
+
+//Returns a trigger to the pool. The serial is bumped
+//so the handles of the old trigger become stale.
+void FInstructionScheduler::Release(int32 TriggerIndex)
+{
+	m_Triggers[TriggerIndex].m_Serial++;
+	m_FreeTriggers.Add(TriggerIndex);
+	m_NumPending--;
+}
+
+//Moves every trigger of the current slot of a level to the lower levels.
+void FInstructionScheduler::Cascade(int32 Level)
+{
+	const int32 slot = Level * SlotsPerLevel + int32((m_CurrentTick >> (SlotBits * Level)) & SlotMask);
+	int32 triggerIndex = m_SlotHeads[slot];
+	m_SlotHeads[slot] = INDEX_NONE;
+	while (triggerIndex != INDEX_NONE)
+	{
+		const int32 next = m_Triggers[triggerIndex].m_Next;
+		Insert(triggerIndex);
+		triggerIndex = next;
+	}
+}
+
+//Processes the current tick: cascades the coarser levels when the
+//finer ones wrap around, then fires the triggers of the first level slot.
+void FInstructionScheduler::ProcessTick(TArray<Instructions>& Fired)
+{
+	for (int32 level = 1; level < NumLevels; level++)
+	{
+		if ((m_CurrentTick & ((uint64(1) << (SlotBits * level)) - 1)) != 0)
+		{
+			break;
+		}
+		Cascade(level);
+	}
+
+	const int32 slot = int32(m_CurrentTick & SlotMask);
+	int32 triggerIndex = m_SlotHeads[slot];
+	m_SlotHeads[slot] = INDEX_NONE;
+	while (triggerIndex != INDEX_NONE)
+	{
+		FTrigger& trigger = m_Triggers[triggerIndex];
+		const int32 next = trigger.m_Next;
+		trigger.m_Slot = INDEX_NONE;
+
+		if (trigger.m_ExpireTick > m_CurrentTick)
+		{
+			//Clamped trigger that is still further than the wheel range.
+			Insert(triggerIndex);
+		}
+		else
+		{
+			Fired.Add(trigger.m_Instruction);
+			if (trigger.m_RepeatTicks > 0)
+			{
+				trigger.m_ExpireTick = m_CurrentTick + trigger.m_RepeatTicks;
+				Insert(triggerIndex);
+			}
+			else
+			{
+				Release(triggerIndex);
+			}
+		}
+		triggerIndex = next;
+	}
+}
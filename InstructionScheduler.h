@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "JsonHelper.h"
+#include "Tickable.h"
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnInstructionsTriggered, const TArray<Instructions>&);
+
+//Handle of a pending instruction trigger, used to cancel or restart it.
+//It remembers what was scheduled, so a trigger that already fired or was
+//cancelled can still be restarted.
+struct COLDWARPROJECT_API FInstructionTriggerHandle
+{
+	int32 m_Index = INDEX_NONE;
+	uint32 m_Serial = 0;
+	TOptional<Instructions> m_Instruction;
+	float m_RepeatInterval = 0.0f;
+
+	bool IsValid() const { return m_Index != INDEX_NONE; }
+	void Invalidate() { m_Index = INDEX_NONE; }
+};
+
+//Central scheduler of the timed instructions (inactivity prompts, reminders,
+//learn more and quiz proposals). Pending triggers are kept in a hierarchical
+//timing wheel, so scheduling and cancelling are O(1) and a tick only visits
+//the slots that expire. Everything that fires in a frame is broadcast at once.
+class COLDWARPROJECT_API FInstructionScheduler : public FTickableGameObject
+{
+public:
+	FInstructionScheduler();
+
+	void SetInstructions(const FInstructionGameData& InstructionData);
+	const FInstructionNarration* GetNarration(Instructions Instruction) const;
+	const FInstructionGameData& GetInstructions() const { return m_InstructionData; }
+
+	FInstructionTriggerHandle Schedule(Instructions Instruction, float Delay, float RepeatInterval = 0.0f);
+	bool Cancel(FInstructionTriggerHandle& Handle);
+	FInstructionTriggerHandle Restart(FInstructionTriggerHandle& Handle, float Delay);
+	void CancelAll();
+	void Advance(float DeltaTime);
+	int32 NumPending() const { return m_NumPending; }
+
+	FOnInstructionsTriggered& OnInstructionsTriggered() { return m_OnInstructionsTriggered; }
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override { Advance(DeltaTime); }
+	virtual bool IsTickable() const override { return m_NumPending > 0; }
+	virtual TStatId GetStatId() const override;
+
+	static constexpr float TickInterval = 0.05f;
+
+private:
+	static constexpr int32 SlotBits = 6;
+	static constexpr int32 SlotsPerLevel = 1 << SlotBits;
+	static constexpr int32 SlotMask = SlotsPerLevel - 1;
+	static constexpr int32 NumLevels = 4;
+
+	struct FTrigger
+	{
+		Instructions m_Instruction;
+		uint64 m_ExpireTick = 0;
+		uint32 m_RepeatTicks = 0;
+		uint32 m_Serial = 0;
+		int32 m_Slot = INDEX_NONE;
+		int32 m_Prev = INDEX_NONE;
+		int32 m_Next = INDEX_NONE;
+	};
+
+	static uint64 SecondsToTicks(float Seconds);
+	void Insert(int32 TriggerIndex);
+	void Unlink(int32 TriggerIndex);
+	void Release(int32 TriggerIndex);
+	void Cascade(int32 Level);
+	void ProcessTick(TArray<Instructions>& Fired);
+
+	FInstructionGameData m_InstructionData;
+	TArray<FTrigger> m_Triggers;
+	TArray<int32> m_FreeTriggers;
+	int32 m_SlotHeads[NumLevels * SlotsPerLevel];
+	uint64 m_CurrentTick = 0;
+	float m_PendingTime = 0.0f;
+	int32 m_NumPending = 0;
+	FOnInstructionsTriggered m_OnInstructionsTriggered;
+};
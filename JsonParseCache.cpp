@@ -0,0 +1,206 @@
+#include "JsonParseCache.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+/*************************************
+Class: FJsonParseCache
+Author: Antoine Plouffe
+
+Description: Derived data cache of the parsed JSON files, stored in
+Saved/GameDataCache. Each entry is named after the SHA1 of the file
+content, the struct name and a hash of the struct properties, so editing
+the file or the struct simply misses the cache. Entries start with a magic
+number and the cache version and are written through a temporary file.
+A content file is read and hashed once however many structs are read
+from it. Misses are parsed by the JSON helper.
+*************************************/
+
+static TAutoConsoleVariable<bool> CVarGameDataParseCache(
+	TEXT("GameData.ParseCache"),
+	true,
+	TEXT("Reads unchanged JSON content files from the local parse cache instead of parsing them again."));
+
+FJsonContentFile::FJsonContentFile(const FString& Path, const FContentFileBatch* Batch)
+	: m_Path(Path)
+{
+	TArray<uint8> fileContent;
+	const TArray<uint8>* content = Batch ? Batch->Find(Path) : nullptr;
+	if (!content && FContentFileReader::ReadFile(Path, fileContent))
+	{
+		content = &fileContent;
+	}
+	m_IsRead = content != nullptr;
+	if (m_IsRead)
+	{
+		FSHA1::HashBuffer(content->GetData(), content->Num(), m_ContentHash.Hash);
+	}
+}
+
+FJsonParseCache::FJsonParseCache()
+{
+	m_CacheDir = FPaths::ProjectSavedDir() / TEXT("GameDataCache");
+}
+
+//Deletes every cached entry, and drops the prefetched structs.
+void FJsonParseCache::Clear()
+{
+	IFileManager::Get().DeleteDirectory(*m_CacheDir, false, true);
+	FScopeLock lock(&m_PrefetchedLock);
+	m_Prefetched.Empty();
+}
+
+bool FJsonParseCache::IsEnabled() const
+{
+	return CVarGameDataParseCache.GetValueOnAnyThread();
+}
+
+//Looks up a struct of a file already read, prefetched or in the cache.
+//Returns false when it has to be parsed.
+bool FJsonParseCache::FindStruct(const FJsonContentFile& File, const UScriptStruct* Struct, void* OutData, FString& infoMessage) const
+{
+	if (TakePrefetched(File, Struct, OutData))
+	{
+		infoMessage = FString("Read From Prefetch");
+		return true;
+	}
+	if (IsEnabled())
+	{
+		if (Load(MakeCacheKey(File.GetContentHash(), Struct), Struct, OutData))
+		{
+			infoMessage = FString("Read From Parse Cache");
+			return true;
+		}
+		//An unreadable entry may have been read in part.
+		Struct->ClearScriptStruct(OutData);
+	}
+	return false;
+}
+
+//Caches a struct the JSON helper parsed from a file already read.
+void FJsonParseCache::AddStruct(const FJsonContentFile& File, const UScriptStruct* Struct, const void* Data) const
+{
+	if (IsEnabled())
+	{
+		Store(MakeCacheKey(File.GetContentHash(), Struct), Struct, Data);
+	}
+}
+
+FString FJsonParseCache::MakeCacheKey(const FSHAHash& ContentHash, const UScriptStruct* Struct) const
+{
+	return FString::Printf(TEXT("%s_%s_%08x"), *ContentHash.ToString(), *Struct->GetName(), GetSchemaHash(Struct));
+}
+
+//Reads a cached struct. Returns false on a miss or an unreadable entry.
+bool FJsonParseCache::Load(const FString& CacheKey, const UScriptStruct* Struct, void* OutData) const
+{
+	TArray<uint8> entry;
+	if (!FFileHelper::LoadFileToArray(entry, *(m_CacheDir / CacheKey + TEXT(".bin")), FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader reader(entry);
+	FObjectAndNameAsStringProxyArchive archive(reader, false);
+	uint32 magic = 0;
+	uint32 version = 0;
+	archive << magic << version;
+	if (magic != Magic || version != Version)
+	{
+		return false;
+	}
+
+	const_cast<UScriptStruct*>(Struct)->SerializeBin(archive, OutData);
+	return !archive.IsError() && reader.AtEnd();
+}
+
+//Writes a parsed struct to the cache. Each write goes through its own
+//temporary file, so threads storing the same key never share one, and
+//the entry only ever appears complete.
+void FJsonParseCache::Store(const FString& CacheKey, const UScriptStruct* Struct, const void* Data) const
+{
+	TArray<uint8> entry;
+	FMemoryWriter writer(entry);
+	FObjectAndNameAsStringProxyArchive archive(writer, false);
+	uint32 magic = Magic;
+	uint32 version = Version;
+	archive << magic << version;
+	const_cast<UScriptStruct*>(Struct)->SerializeBin(archive, const_cast<void*>(Data));
+
+	const FString entryPath = m_CacheDir / CacheKey + TEXT(".bin");
+	const FString tempPath = FString::Printf(TEXT("%s.%s.tmp"), *entryPath, *FGuid::NewGuid().ToString());
+	if (!FFileHelper::SaveArrayToFile(entry, *tempPath) || !IFileManager::Get().Move(*entryPath, *tempPath, true, true))
+	{
+		IFileManager::Get().Delete(*tempPath, false, false, true);
+	}
+}
+
+//Moves a prefetched struct out of the cache. Returns false when the
+//file was not prefetched for that struct, or when its content changed
+//since, in which case the stale struct is dropped.
+bool FJsonParseCache::TakePrefetched(const FJsonContentFile& File, const UScriptStruct* Struct, void* OutData) const
+{
+	FPrefetched prefetched;
+	{
+		FScopeLock lock(&m_PrefetchedLock);
+		if (!m_Prefetched.RemoveAndCopyValue(File.GetPath() + Struct->GetName(), prefetched))
+		{
+			return false;
+		}
+	}
+	if (prefetched.m_ContentHash != File.GetContentHash())
+	{
+		return false;
+	}
+	Struct->CopyScriptStruct(OutData, prefetched.m_Data->GetStructMemory());
+	return true;
+}
+
+//Keeps a prefetched struct, replacing the one of the same file and type.
+//Structs prefetched but never read are dropped after PrefetchLifetime.
+void FJsonParseCache::AddPrefetched(const FJsonContentFile& File, const UScriptStruct* Struct, const void* Data) const
+{
+	FPrefetched prefetched;
+	prefetched.m_Data = MakeShared<FStructOnScope>(Struct);
+	Struct->CopyScriptStruct(prefetched.m_Data->GetStructMemory(), Data);
+	prefetched.m_ContentHash = File.GetContentHash();
+	prefetched.m_Time = FPlatformTime::Seconds();
+
+	FScopeLock lock(&m_PrefetchedLock);
+	for (auto it = m_Prefetched.CreateIterator(); it; ++it)
+	{
+		if (prefetched.m_Time - it->Value.m_Time > PrefetchLifetime)
+		{
+			it.RemoveCurrent();
+		}
+	}
+	m_Prefetched.Add(File.GetPath() + Struct->GetName(), MoveTemp(prefetched));
+}
+
+//Hashes the names and types of the properties of a struct, including
+//nested structs, so any change to the schema invalidates the cache.
+uint32 FJsonParseCache::GetSchemaHash(const UStruct* Struct)
+{
+	uint32 hash = 0;
+	for (TFieldIterator<FProperty> it(Struct); it; ++it)
+	{
+		hash = FCrc::StrCrc32(*it->GetName(), hash);
+		hash = FCrc::StrCrc32(*it->GetCPPType(), hash);
+
+		FProperty* property = *it;
+		if (FArrayProperty* arrayProperty = CastField<FArrayProperty>(property))
+		{
+			property = arrayProperty->Inner;
+		}
+		if (FStructProperty* structProperty = CastField<FStructProperty>(property))
+		{
+			hash = HashCombine(hash, GetSchemaHash(structProperty->Struct));
+		}
+	}
+	return hash;
+}
@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ContentFileReader.h"
+#include "JsonHelper.h"
+#include "Misc/SecureHash.h"
+#include "UObject/StructOnScope.h"
+
+//A JSON content file read once to look up several structs of it in the
+//parse cache. The content is read, or taken from a batch, and hashed when
+//the file is created; only the hash is kept, so the file can be handed
+//from a worker thread to the game thread. Structs missing from the cache
+//are still parsed by the JSON helper, which picks the parsing by type.
+class COLDWARPROJECT_API FJsonContentFile
+{
+public:
+	explicit FJsonContentFile(const FString& Path, const FContentFileBatch* Batch = nullptr);
+
+	const FString& GetPath() const { return m_Path; }
+	bool IsRead() const { return m_IsRead; }
+	const FSHAHash& GetContentHash() const { return m_ContentHash; }
+
+private:
+	FString m_Path;
+	bool m_IsRead = false;
+	FSHAHash m_ContentHash;
+};
+
+//Local cache of parsed JSON structs, keyed by the content hash of the file,
+//the struct type and its schema. A file that did not change since the last
+//session is not parsed again: the struct is read back from its binary form.
+//Structs can also be prefetched on a worker thread, and are then handed
+//to the next read of the same file and type without parsing it again, as
+//long as the file content did not change in between.
+//Files read beforehand in a batch are hashed from the batch content.
+class COLDWARPROJECT_API FJsonParseCache
+{
+public:
+	FJsonParseCache();
+
+	template<typename T>
+	T ReadStructFromJsonFile(UJsonHelper* JsonHelper, const FString& Path, bool& success, FString& infoMessage, const FContentFileBatch* Batch = nullptr) const;
+	template<typename T>
+	T ReadStruct(UJsonHelper* JsonHelper, const FJsonContentFile& File, bool& success, FString& infoMessage) const;
+	template<typename T>
+	void Prefetch(UJsonHelper* JsonHelper, const FString& Path, const FContentFileBatch* Batch = nullptr) const;
+	template<typename T>
+	void Prefetch(UJsonHelper* JsonHelper, const FJsonContentFile& File) const;
+
+	void Clear();
+	void SetCacheDir(const FString& CacheDir) { m_CacheDir = CacheDir; }
+
+	static constexpr uint32 Magic = 0x43504447; //GDPC
+	static constexpr uint32 Version = 3;
+	static constexpr double PrefetchLifetime = 120.0;
+
+private:
+	bool IsEnabled() const;
+	bool FindStruct(const FJsonContentFile& File, const UScriptStruct* Struct, void* OutData, FString& infoMessage) const;
+	void AddStruct(const FJsonContentFile& File, const UScriptStruct* Struct, const void* Data) const;
+	FString MakeCacheKey(const FSHAHash& ContentHash, const UScriptStruct* Struct) const;
+	bool Load(const FString& CacheKey, const UScriptStruct* Struct, void* OutData) const;
+	void Store(const FString& CacheKey, const UScriptStruct* Struct, const void* Data) const;
+	static uint32 GetSchemaHash(const UStruct* Struct);
+
+	bool TakePrefetched(const FJsonContentFile& File, const UScriptStruct* Struct, void* OutData) const;
+	void AddPrefetched(const FJsonContentFile& File, const UScriptStruct* Struct, const void* Data) const;
+
+	//Prefetched struct, with the hash of the content it was read from.
+	struct FPrefetched
+	{
+		TSharedPtr<FStructOnScope> m_Data;
+		FSHAHash m_ContentHash;
+		double m_Time = 0.0;
+	};
+
+	FString m_CacheDir;
+	mutable FCriticalSection m_PrefetchedLock;
+	mutable TMap<FString, FPrefetched> m_Prefetched;
+};
+
+//Returns the struct of the given JSON file, from the cache when the file
+//content did not change, otherwise parsed from the file and cached.
+template<typename T>
+T FJsonParseCache::ReadStructFromJsonFile(UJsonHelper* JsonHelper, const FString& Path, bool& success, FString& infoMessage, const FContentFileBatch* Batch) const
+{
+	const FJsonContentFile file(Path, Batch);
+	return ReadStruct<T>(JsonHelper, file, success, infoMessage);
+}
+
+//Same as ReadStructFromJsonFile for a file already read, so the structs
+//of one file share a single read and hash. A struct missing from the
+//cache, or a file that could not be read, is left to the JSON helper,
+//which parses it or reports why it could not.
+template<typename T>
+T FJsonParseCache::ReadStruct(UJsonHelper* JsonHelper, const FJsonContentFile& File, bool& success, FString& infoMessage) const
+{
+	if (!File.IsRead())
+	{
+		return JsonHelper->ReadStructFromJsonFile<T>(File.GetPath(), success, infoMessage);
+	}
+
+	T data;
+	if (FindStruct(File, T::StaticStruct(), &data, infoMessage))
+	{
+		success = true;
+		return data;
+	}
+	data = JsonHelper->ReadStructFromJsonFile<T>(File.GetPath(), success, infoMessage);
+	if (success)
+	{
+		AddStruct(File, T::StaticStruct(), &data);
+	}
+	return data;
+}
+
+//Reads the struct of the given JSON file and keeps it for the next read.
+//Safe to call from a worker thread. Failed reads are not kept, so the
+//next read reports the error.
+template<typename T>
+void FJsonParseCache::Prefetch(UJsonHelper* JsonHelper, const FString& Path, const FContentFileBatch* Batch) const
+{
+	const FJsonContentFile file(Path, Batch);
+	Prefetch<T>(JsonHelper, file);
+}
+
+template<typename T>
+void FJsonParseCache::Prefetch(UJsonHelper* JsonHelper, const FJsonContentFile& File) const
+{
+	bool success;
+	FString message;
+	const T data = ReadStruct<T>(JsonHelper, File, success, message);
+	if (success)
+	{
+		AddPrefetched(File, T::StaticStruct(), &data);
+	}
+}
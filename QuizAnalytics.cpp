@@ -0,0 +1,213 @@
+#include "QuizAnalytics.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+
+/*************************************
+Class: FQuizAnalytics
+Author: Antoine Plouffe
+
+Description: Collects how many times each option of each quiz question is
+selected. Every thread recording answers gets two fixed tables of atomic
+counters, linked in a lock-free list. Once per minute, a thread pool task
+swaps the tables, drains and empties the previous ones and appends one
+CSV record per counted option to Saved/QuizAnalytics/QuizAnswers.csv.
+Answers that do not fit in a full table until the next flush are dropped
+and counted instead of growing memory.
+*************************************/
+
+FQuizAnalytics& FQuizAnalytics::Get()
+{
+	static FQuizAnalytics instance;
+	return instance;
+}
+
+FQuizAnalytics::FQuizAnalytics()
+{
+	m_FilePath = FPaths::ProjectSavedDir() / TEXT("QuizAnalytics") / TEXT("QuizAnswers.csv");
+	m_FlushTimerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FQuizAnalytics::OnFlushTimer), FlushInterval);
+	FCoreDelegates::OnPreExit.AddRaw(this, &FQuizAnalytics::Shutdown);
+}
+
+//Frees the counter tables. The tables are only freed here,
+//since threads keep a pointer to their own.
+FQuizAnalytics::~FQuizAnalytics()
+{
+	FThreadCounters* threadCounters = m_ThreadCounters.exchange(nullptr);
+	while (threadCounters)
+	{
+		FThreadCounters* next = threadCounters->m_Next;
+		delete threadCounters;
+		threadCounters = next;
+	}
+}
+
+//Stops the flush timer and writes what is left before the engine exits.
+void FQuizAnalytics::Shutdown()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(m_FlushTimerHandle);
+	Flush(true);
+}
+
+//Returns a stable key for a question, made from its option names,
+//so the records of a question match across sessions and kiosks.
+uint32 FQuizAnalytics::MakeQuestionKey(const TArray<FString>& OptionNames)
+{
+	uint32 key = 0;
+	for (const FString& optionName : OptionNames)
+	{
+		key = FCrc::StrCrc32(*optionName, key);
+	}
+	return key;
+}
+
+//Counts a selected option. Lock free and allocation free, except
+//for the first answer recorded by a thread.
+void FQuizAnalytics::RecordAnswer(uint32 QuestionKey, int32 OptionIndex)
+{
+	const uint64 key = (uint64(QuestionKey) << 32) | KeyInUse | (uint32(OptionIndex + 1) & 0x7fffffff);
+	FThreadCounters& threadCounters = GetThreadCounters();
+
+	//Flagged before reading the active table, so the flush task either sees
+	//the flag and waits, or this thread sees the table it switched to.
+	threadCounters.m_IsRecording.store(true);
+	FCounter* counters = threadCounters.m_Counters[threadCounters.m_ActiveTable.load()];
+
+	uint32 slot = GetTypeHash(key) & (CountersPerThread - 1);
+	for (int probe = 0; probe < CountersPerThread; probe++)
+	{
+		FCounter& counter = counters[slot];
+		const uint64 slotKey = counter.m_Key.load(std::memory_order_relaxed);
+		if (slotKey == key)
+		{
+			counter.m_Count.fetch_add(1, std::memory_order_relaxed);
+			threadCounters.m_IsRecording.store(false, std::memory_order_release);
+			return;
+		}
+		if (slotKey == 0)
+		{
+			counter.m_Key.store(key, std::memory_order_relaxed);
+			counter.m_Count.fetch_add(1, std::memory_order_relaxed);
+			threadCounters.m_IsRecording.store(false, std::memory_order_release);
+			return;
+		}
+		slot = (slot + 1) & (CountersPerThread - 1);
+	}
+	threadCounters.m_IsRecording.store(false, std::memory_order_release);
+	m_Dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+//Drains the counters and writes them on a worker thread. Skipped when a
+//flush is already running; with bWait, runs on the calling thread instead.
+void FQuizAnalytics::Flush(bool bWait)
+{
+	bool expected = false;
+	if (!m_IsFlushing.compare_exchange_strong(expected, true))
+	{
+		if (!bWait)
+		{
+			return;
+		}
+		while (m_IsFlushing.exchange(true))
+		{
+			FPlatformProcess::Yield();
+		}
+	}
+
+	if (bWait)
+	{
+		DrainAndWrite();
+		m_IsFlushing.store(false);
+		return;
+	}
+
+	Async(EAsyncExecution::ThreadPool, [this]()
+	{
+		DrainAndWrite();
+		m_IsFlushing.store(false);
+	});
+}
+
+//Returns the counter table of the calling thread, creating
+//it and pushing it on the lock-free list the first time.
+FQuizAnalytics::FThreadCounters& FQuizAnalytics::GetThreadCounters()
+{
+	static thread_local FThreadCounters* threadCounters = nullptr;
+	if (!threadCounters)
+	{
+		threadCounters = new FThreadCounters();
+		FThreadCounters* head = m_ThreadCounters.load(std::memory_order_relaxed);
+		do
+		{
+			threadCounters->m_Next = head;
+		} while (!m_ThreadCounters.compare_exchange_weak(head, threadCounters, std::memory_order_release, std::memory_order_relaxed));
+	}
+	return *threadCounters;
+}
+
+bool FQuizAnalytics::OnFlushTimer(float DeltaTime)
+{
+	Flush();
+	return true;
+}
+
+//Takes the counts of every thread, merges them by question and option,
+//and appends the records to the CSV file. Runs on a single thread at a time.
+void FQuizAnalytics::DrainAndWrite()
+{
+	TMap<uint64, uint32> counts;
+	for (FThreadCounters* threadCounters = m_ThreadCounters.load(std::memory_order_acquire); threadCounters; threadCounters = threadCounters->m_Next)
+	{
+		const uint32 drainedTable = threadCounters->m_ActiveTable.load();
+		threadCounters->m_ActiveTable.store(drainedTable ^ 1);
+		while (threadCounters->m_IsRecording.load())
+		{
+			FPlatformProcess::Yield();
+		}
+
+		for (FCounter& counter : threadCounters->m_Counters[drainedTable])
+		{
+			const uint64 key = counter.m_Key.load(std::memory_order_relaxed);
+			const uint32 count = counter.m_Count.load(std::memory_order_relaxed);
+			if (key != 0 && count != 0)
+			{
+				counts.FindOrAdd(key) += count;
+			}
+			counter.m_Key.store(0, std::memory_order_relaxed);
+			counter.m_Count.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	const uint64 dropped = m_Dropped.exchange(0, std::memory_order_relaxed);
+	if (counts.Num() == 0 && dropped == 0)
+	{
+		return;
+	}
+
+	IFileManager& fileManager = IFileManager::Get();
+	const bool isNewFile = !fileManager.FileExists(*m_FilePath);
+	TUniquePtr<FArchive> writer(fileManager.CreateFileWriter(*m_FilePath, FILEWRITE_Append | FILEWRITE_AllowRead));
+	if (!writer)
+	{
+		return;
+	}
+
+	const FString timestamp = FDateTime::UtcNow().ToIso8601();
+	FString records;
+	if (isNewFile)
+	{
+		records += TEXT("Timestamp,QuestionKey,OptionIndex,Count\n");
+	}
+	for (const TPair<uint64, uint32>& count : counts)
+	{
+		records += FString::Printf(TEXT("%s,%08x,%d,%u\n"), *timestamp, uint32(count.Key >> 32), int32(count.Key & 0x7fffffff) - 1, count.Value);
+	}
+	if (dropped > 0)
+	{
+		records += FString::Printf(TEXT("%s,dropped,,%llu\n"), *timestamp, dropped);
+	}
+
+	FTCHARToUTF8 utf8(*records);
+	writer->Serialize((void*)utf8.Get(), utf8.Length());
+}
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include <atomic>
+
+//Answer statistics of the quiz, collected on the kiosks. Recording an answer
+//only bumps a counter in a table owned by the calling thread, without locks
+//or allocations. A background task periodically drains every table, merges
+//the counts and appends them to a CSV file, so the game thread never waits
+//on file I/O and the memory used stays bounded.
+class COLDWARPROJECT_API FQuizAnalytics
+{
+public:
+	static FQuizAnalytics& Get();
+	~FQuizAnalytics();
+
+	static uint32 MakeQuestionKey(const TArray<FString>& OptionNames);
+	void RecordAnswer(uint32 QuestionKey, int32 OptionIndex);
+	void Flush(bool bWait = false);
+	void Shutdown();
+	uint64 NumDropped() const { return m_Dropped.load(std::memory_order_relaxed); }
+
+	static constexpr int32 CountersPerThread = 512;
+	static constexpr float FlushInterval = 60.0f;
+
+private:
+	FQuizAnalytics();
+
+	struct FCounter
+	{
+		std::atomic<uint64> m_Key { 0 };
+		std::atomic<uint32> m_Count { 0 };
+	};
+
+	//Counters of one thread, in two tables. The owner thread records in the
+	//active table; the flush task makes the other one active, waits for a
+	//recording in progress, then drains and empties the previous one, so
+	//the keys are recycled on every flush.
+	struct FThreadCounters
+	{
+		FCounter m_Counters[2][CountersPerThread];
+		std::atomic<uint32> m_ActiveTable { 0 };
+		std::atomic<bool> m_IsRecording { false };
+		FThreadCounters* m_Next = nullptr;
+	};
+
+	//Marks the key of a counter in use, so no question and option pair
+	//encodes to 0, the key of an empty counter.
+	static constexpr uint64 KeyInUse = 0x80000000;
+
+	FThreadCounters& GetThreadCounters();
+	bool OnFlushTimer(float DeltaTime);
+	void DrainAndWrite();
+
+	std::atomic<FThreadCounters*> m_ThreadCounters { nullptr };
+	std::atomic<uint64> m_Dropped { 0 };
+	std::atomic<bool> m_IsFlushing { false };
+	FTSTicker::FDelegateHandle m_FlushTimerHandle;
+	FString m_FilePath;
+};
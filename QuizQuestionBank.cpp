@@ -0,0 +1,158 @@
+#include "QuizQuestionBank.h"
+#include "Algo/BinarySearch.h"
+
+/*************************************
+Class: FQuizQuestionBank
+Author: Antoine Plouffe
+
+Description: Paged question bank for the quiz. The index lists the page
+files with their number of questions, so a question is located by a
+binary search over the first question of each page. A quiz samples the
+questions it needs from the index and only reads the pages they live in,
+returning a regular FQuizQuestions that PopulateQuizUI can use as is.
+*************************************/
+
+//Reads the index of the bank. Page paths are relative to the index file.
+bool FQuizQuestionBank::Open(UJsonHelper* JsonHelper, const FString& IndexPath, FString& infoMessage)
+{
+	Close();
+	bool success;
+	m_JsonHelper = JsonHelper;
+	m_RootPath = FPaths::GetPath(IndexPath);
+	m_Index = m_JsonHelper->ReadStructFromJsonFile<FQuizBankIndex>(IndexPath, success, infoMessage);
+	if (!success)
+	{
+		return false;
+	}
+
+	for (const FQuizBankPageEntry& page : m_Index.Pages)
+	{
+		m_TotalQuestions += FMath::Max(page.NumQuestions, 0);
+	}
+	return true;
+}
+
+void FQuizQuestionBank::Close()
+{
+	m_Index.Pages.Empty();
+	m_CachedPages.Empty();
+	m_TotalQuestions = 0;
+}
+
+//Picks Count distinct questions at random (Floyd's algorithm), in random
+//order, optionally only from the pages of a checkpoint. Only the index is used, so the cost
+//does not depend on the size of the bank.
+TArray<FQuizQuestionRef> FQuizQuestionBank::SampleQuestions(int32 Count, FRandomStream& RandomStream, int32 CorrespondingCPIndex) const
+{
+	TArray<int32> pageIndices;
+	TArray<int32> pageFirstQuestion;
+	int32 numQuestions = 0;
+	for (int i = 0; i < m_Index.Pages.Num(); i++)
+	{
+		if (CorrespondingCPIndex == INDEX_NONE || m_Index.Pages[i].CorrespondingCPIndex == CorrespondingCPIndex)
+		{
+			pageIndices.Add(i);
+			pageFirstQuestion.Add(numQuestions);
+			numQuestions += FMath::Max(m_Index.Pages[i].NumQuestions, 0);
+		}
+	}
+
+	Count = FMath::Min(Count, numQuestions);
+	TSet<int32> picked;
+	TArray<FQuizQuestionRef> questionRefs;
+	questionRefs.Reserve(Count);
+	for (int j = numQuestions - Count; j < numQuestions; j++)
+	{
+		int32 candidate = RandomStream.RandRange(0, j);
+		if (picked.Contains(candidate))
+		{
+			candidate = j;
+		}
+		picked.Add(candidate);
+
+		const int32 page = Algo::UpperBound(pageFirstQuestion, candidate) - 1;
+		FQuizQuestionRef questionRef;
+		questionRef.m_PageIndex = pageIndices[page];
+		questionRef.m_QuestionIndex = candidate - pageFirstQuestion[page];
+		questionRefs.Add(questionRef);
+	}
+
+	//Floyd's algorithm picks a uniform set but not a uniform order: the
+	//last questions of the range tend to come last, so the set is shuffled.
+	for (int i = questionRefs.Num() - 1; i > 0; i--)
+	{
+		questionRefs.Swap(i, RandomStream.RandRange(0, i));
+	}
+	return questionRefs;
+}
+
+//Gathers the referenced questions, with their options, into an
+//FQuizQuestions, reading the pages that are not cached yet.
+FQuizQuestions FQuizQuestionBank::LoadQuestions(const TArray<FQuizQuestionRef>& QuestionRefs, bool& success, FString& infoMessage)
+{
+	FQuizQuestions quizData;
+	success = true;
+	infoMessage = FString("Questions Loaded");
+
+	for (const FQuizQuestionRef& questionRef : QuestionRefs)
+	{
+		bool pageSuccess;
+		const FQuizQuestions* page = LoadPage(questionRef.m_PageIndex, pageSuccess, infoMessage);
+		if (!pageSuccess || !page)
+		{
+			success = false;
+			continue;
+		}
+		if (!page->m_Questions.IsValidIndex(questionRef.m_QuestionIndex))
+		{
+			success = false;
+			infoMessage = FString::Printf(TEXT("Quiz Question %d Not Found In Page %d"), questionRef.m_QuestionIndex, questionRef.m_PageIndex);
+			continue;
+		}
+		quizData.m_Questions.Add(page->m_Questions[questionRef.m_QuestionIndex]);
+	}
+	return quizData;
+}
+
+//Returns a page from the cache, reading it if needed. The cache is
+//ordered from the most to the least recently used page.
+const FQuizQuestions* FQuizQuestionBank::LoadPage(int32 PageIndex, bool& success, FString& infoMessage)
+{
+	success = false;
+	if (!m_JsonHelper || !m_Index.Pages.IsValidIndex(PageIndex))
+	{
+		infoMessage = FString("Quiz Page Not Found");
+		return nullptr;
+	}
+
+	for (int i = 0; i < m_CachedPages.Num(); i++)
+	{
+		if (m_CachedPages[i].m_PageIndex == PageIndex)
+		{
+			if (i > 0)
+			{
+				FCachedPage cachedPage = MoveTemp(m_CachedPages[i]);
+				m_CachedPages.RemoveAt(i);
+				m_CachedPages.Insert(MoveTemp(cachedPage), 0);
+			}
+			success = true;
+			return &m_CachedPages[0].m_Questions;
+		}
+	}
+
+	const FString pagePath = FPaths::Combine(m_RootPath, m_Index.Pages[PageIndex].PagePath);
+	FCachedPage cachedPage;
+	cachedPage.m_PageIndex = PageIndex;
+	cachedPage.m_Questions = m_JsonHelper->ReadStructFromJsonFile<FQuizQuestions>(pagePath, success, infoMessage);
+	if (!success)
+	{
+		return nullptr;
+	}
+
+	if (m_CachedPages.Num() >= MaxCachedPages)
+	{
+		m_CachedPages.Pop();
+	}
+	m_CachedPages.Insert(MoveTemp(cachedPage), 0);
+	return &m_CachedPages[0].m_Questions;
+}
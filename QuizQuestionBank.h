@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "JsonHelper.h"
+#include "QuizQuestionBank.generated.h"
+
+//Page of a question bank. The page file itself has the same format as
+//quiz.json, so a page is read as a regular FQuizQuestions.
+USTRUCT()
+struct FQuizBankPageEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		FString PagePath;
+	UPROPERTY()
+		int32 NumQuestions = 0;
+	UPROPERTY()
+		int32 CorrespondingCPIndex = INDEX_NONE;
+};
+
+//Index file of a question bank, the only part kept in memory.
+USTRUCT()
+struct FQuizBankIndex
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<FQuizBankPageEntry> Pages;
+};
+
+//Location of a question in the bank.
+struct COLDWARPROJECT_API FQuizQuestionRef
+{
+	int32 m_PageIndex = INDEX_NONE;
+	int32 m_QuestionIndex = INDEX_NONE;
+};
+
+//Question bank split in pages. Only the index is loaded when the bank is
+//opened; pages are read when one of their questions is needed and a few
+//of them are kept in a small most recently used cache.
+class COLDWARPROJECT_API FQuizQuestionBank
+{
+public:
+	bool Open(UJsonHelper* JsonHelper, const FString& IndexPath, FString& infoMessage);
+	void Close();
+
+	int32 NumQuestions() const { return m_TotalQuestions; }
+	int32 NumPages() const { return m_Index.Pages.Num(); }
+	TArray<FQuizQuestionRef> SampleQuestions(int32 Count, FRandomStream& RandomStream, int32 CorrespondingCPIndex = INDEX_NONE) const;
+	FQuizQuestions LoadQuestions(const TArray<FQuizQuestionRef>& QuestionRefs, bool& success, FString& infoMessage);
+
+	static constexpr int32 MaxCachedPages = 4;
+
+private:
+	const FQuizQuestions* LoadPage(int32 PageIndex, bool& success, FString& infoMessage);
+
+	UJsonHelper* m_JsonHelper = nullptr;
+	FString m_RootPath;
+	FQuizBankIndex m_Index;
+	int32 m_TotalQuestions = 0;
+
+	struct FCachedPage
+	{
+		int32 m_PageIndex = INDEX_NONE;
+		FQuizQuestions m_Questions;
+	};
+	TArray<FCachedPage> m_CachedPages;
+};
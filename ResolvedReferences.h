@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ResolvedReferences.generated.h"
+
+//Table of the content references resolved offline by the content validation
+//commandlet: asset and checkpoint names mapped to their object paths.
+USTRUCT()
+struct FResolvedReferenceTable
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TMap<FString, FString> Sounds;
+	UPROPERTY()
+		TMap<FString, FString> Images;
+	UPROPERTY()
+		TMap<FString, FString> Checkpoints;
+};
@@ -0,0 +1,156 @@
+#include "SessionState.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+/*************************************
+Class: FVisitorSessionStore
+Author: Antoine Plouffe
+
+Description: Binary snapshot of the visitor progress (checkpoint index,
+completed learn more entries, quiz progress). The record starts with a
+magic number and a version and ends with a CRC, so a record from another
+build or a partially written file is rejected instead of restored.
+*************************************/
+
+void FVisitorSessionState::Reset(uint32 TourKey)
+{
+	m_TourKey = TourKey;
+	m_CheckpointIndex = INDEX_NONE;
+	m_CompletedLearnMore.Empty();
+	m_QuizQuestionIndex = INDEX_NONE;
+	m_QuizAnswers.Empty();
+}
+
+FArchive& operator<<(FArchive& Ar, FVisitorSessionState& State)
+{
+	Ar << State.m_TourKey;
+	Ar << State.m_CheckpointIndex;
+	Ar << State.m_CompletedLearnMore;
+	Ar << State.m_QuizQuestionIndex;
+	Ar << State.m_QuizAnswers;
+	return Ar;
+}
+
+FVisitorSessionStore::FVisitorSessionStore()
+	: m_PendingWrites(MakeShared<FPendingWrites, ESPMode::ThreadSafe>())
+{
+	m_FilePath = FPaths::ProjectSavedDir() / TEXT("Session") / TEXT("VisitorSession.bin");
+}
+
+//Serializes the state and writes it on a worker thread.
+void FVisitorSessionStore::SaveAsync(const FVisitorSessionState& State)
+{
+	TArray<uint8> record;
+	FMemoryWriter writer(record);
+	uint32 magic = Magic;
+	uint16 version = Version;
+	writer << magic << version;
+	writer << const_cast<FVisitorSessionState&>(State);
+	uint32 crc = FCrc::MemCrc32(record.GetData(), record.Num());
+	writer << crc;
+
+	Write(MoveTemp(record));
+}
+
+//Hands a record to the writer, replacing the one still waiting. Starts the
+//writer when none is running; it then writes the pending records one after
+//the other until there is none left.
+void FVisitorSessionStore::Write(TArray<uint8>&& Record)
+{
+	{
+		FScopeLock lock(&m_PendingWrites->m_Lock);
+		m_PendingWrites->m_Record = MoveTemp(Record);
+		if (m_PendingWrites->m_IsWriting)
+		{
+			return;
+		}
+		m_PendingWrites->m_IsWriting = true;
+	}
+
+	Async(EAsyncExecution::ThreadPool, [pendingWrites = m_PendingWrites, filePath = m_FilePath]()
+	{
+		while (true)
+		{
+			TArray<uint8> record;
+			{
+				FScopeLock lock(&pendingWrites->m_Lock);
+				if (!pendingWrites->m_Record.IsSet())
+				{
+					pendingWrites->m_IsWriting = false;
+					return;
+				}
+				record = MoveTemp(pendingWrites->m_Record.GetValue());
+				pendingWrites->m_Record.Reset();
+			}
+
+			if (record.Num() == 0)
+			{
+				IFileManager::Get().Delete(*filePath, false, false, true);
+				continue;
+			}
+			const FString tempPath = filePath + TEXT(".tmp");
+			if (FFileHelper::SaveArrayToFile(record, *tempPath))
+			{
+				IFileManager::Get().Move(*filePath, *tempPath, true, true);
+			}
+		}
+	});
+}
+
+//Reads the last saved state. Returns false when there is no record or
+//when it is from another version or corrupted.
+bool FVisitorSessionStore::Restore(FVisitorSessionState& OutState, FString& infoMessage) const
+{
+	TArray<uint8> record;
+	if (!FFileHelper::LoadFileToArray(record, *m_FilePath, FILEREAD_Silent))
+	{
+		infoMessage = FString("No Session To Restore");
+		return false;
+	}
+
+	const int32 crcOffset = record.Num() - (int32)sizeof(uint32);
+	if (crcOffset < (int32)(sizeof(uint32) + sizeof(uint16)))
+	{
+		infoMessage = FString("Session Record Too Small");
+		return false;
+	}
+
+	uint32 crc;
+	FMemory::Memcpy(&crc, record.GetData() + crcOffset, sizeof(uint32));
+	if (crc != FCrc::MemCrc32(record.GetData(), crcOffset))
+	{
+		infoMessage = FString("Session Record Corrupted");
+		return false;
+	}
+
+	FMemoryReader reader(record);
+	uint32 magic;
+	uint16 version;
+	reader << magic << version;
+	if (magic != Magic || version != Version)
+	{
+		infoMessage = FString("Session Record Version Mismatch");
+		return false;
+	}
+
+	reader << OutState;
+	if (reader.IsError())
+	{
+		infoMessage = FString("Session Record Unreadable");
+		return false;
+	}
+
+	infoMessage = FString("Session Restored");
+	return true;
+}
+
+//Deletes the saved state, once the visitor completed the tour. The file is
+//deleted by the writer, after the saves made before.
+void FVisitorSessionStore::Clear()
+{
+	Write(TArray<uint8>());
+}
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Progress of the visitor in the current tour, saved at each checkpoint so a
+//kiosk that crashes or is reset can resume the tour where it was.
+struct COLDWARPROJECT_API FVisitorSessionState
+{
+	uint32 m_TourKey = 0;
+	int32 m_CheckpointIndex = INDEX_NONE;
+	TBitArray<> m_CompletedLearnMore;
+	int32 m_QuizQuestionIndex = INDEX_NONE;
+	TArray<int8> m_QuizAnswers;
+
+	void Reset(uint32 TourKey);
+	friend FArchive& operator<<(FArchive& Ar, FVisitorSessionState& State);
+};
+
+//Saves and restores the session state in a small binary file. The record
+//is built on the game thread (a few dozen bytes) and written on a worker
+//thread through a temporary file, so a crash while saving never leaves a
+//broken record behind. A single write runs at a time; saves made during
+//a write replace each other and only the latest is written after it.
+class COLDWARPROJECT_API FVisitorSessionStore
+{
+public:
+	FVisitorSessionStore();
+
+	void SaveAsync(const FVisitorSessionState& State);
+	bool Restore(FVisitorSessionState& OutState, FString& infoMessage) const;
+	void Clear();
+	void SetFilePath(const FString& FilePath) { m_FilePath = FilePath; }
+
+	static constexpr uint32 Magic = 0x53534447; //GDSS
+	static constexpr uint16 Version = 1;
+
+private:
+	//Record waiting for the writer. An empty record deletes the file, so a
+	//Clear is ordered with the saves before it.
+	struct FPendingWrites
+	{
+		FCriticalSection m_Lock;
+		TOptional<TArray<uint8>> m_Record;
+		bool m_IsWriting = false;
+	};
+
+	void Write(TArray<uint8>&& Record);
+
+	FString m_FilePath;
+	TSharedRef<FPendingWrites, ESPMode::ThreadSafe> m_PendingWrites;
+};
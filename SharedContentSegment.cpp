@@ -0,0 +1,253 @@
+#include "SharedContentSegment.h"
+#include "Algo/BinarySearch.h"
+#include "HAL/FileManager.h"
+
+/*************************************
+Class: FSharedContentSegment
+Author: Antoine Plouffe
+
+Description: Layout of the shared caption region. A header is followed by
+the caption entries, the key index sorted by hash and the character pool
+holding every key and text. All offsets are in bytes from the start of the
+region. The region is named after the content and the culture, so processes
+that did not load the same content never share a region. The header state
+tells the other processes when the publisher is done writing, and a process
+mapping an existing region checks that its keys match the region before
+using it. Regions that never become ready, for instance because the
+publisher crashed while writing, are not used.
+*************************************/
+
+namespace
+{
+	enum ESharedContentState : int32
+	{
+		Empty = 0,
+		Writing = 1,
+		Ready = 2,
+	};
+
+	struct FSharedContentHeader
+	{
+		uint32 m_Magic;
+		uint16 m_Version;
+		uint16 m_CharSize;
+		volatile int32 m_State;
+		uint32 m_Size;
+		int32 m_NumCaptions;
+		uint32 m_CaptionsOffset;
+		uint32 m_IndexOffset;
+		uint32 m_CharsOffset;
+	};
+
+	struct FSharedCaption
+	{
+		uint32 m_KeyOffset;
+		uint32 m_KeyLength;
+		uint32 m_TextOffset;
+		uint32 m_TextLength;
+	};
+
+	struct FSharedKeyIndex
+	{
+		uint32 m_Hash;
+		int32 m_Id;
+	};
+
+	constexpr double ReadyTimeout = 0.5;
+
+	uint32 HashKey(FStringView Key)
+	{
+		return FCrc::MemCrc32(Key.GetData(), Key.Len() * sizeof(TCHAR));
+	}
+
+	SIZE_T ComputeSize(TArrayView<const FString> Keys, TArrayView<const FText> Texts)
+	{
+		SIZE_T numChars = 0;
+		for (int i = 0; i < Keys.Num(); i++)
+		{
+			numChars += Keys[i].Len() + Texts[i].ToString().Len();
+		}
+		return sizeof(FSharedContentHeader) + Keys.Num() * (sizeof(FSharedCaption) + sizeof(FSharedKeyIndex)) + numChars * sizeof(TCHAR);
+	}
+
+	//On Linux, a region being created has no size until the creator
+	//truncated it, and touching it would raise SIGBUS.
+	bool HasRegionSize(const FString& Name, SIZE_T Size)
+	{
+#if PLATFORM_LINUX
+		return IFileManager::Get().FileSize(*(TEXT("/dev/shm/") + Name)) >= (int64)Size;
+#else
+		return true;
+#endif
+	}
+}
+
+//Maps the region of the given name, publishing the keys and texts in it
+//when no process did yet. Returns nullptr when the region cannot be used,
+//in which case the caller keeps its own copy.
+TSharedPtr<FSharedContentSegment> FSharedContentSegment::Open(const FString& Name, TArrayView<const FString> Keys, TArrayView<const FText> Texts)
+{
+	check(Keys.Num() == Texts.Num());
+	const SIZE_T size = ComputeSize(Keys, Texts);
+	if (size > MAX_uint32)
+	{
+		return nullptr;
+	}
+
+	TSharedPtr<FSharedContentSegment> segment = MakeShareable(new FSharedContentSegment());
+	segment->m_Name = Name;
+	segment->m_Size = size;
+	segment->m_Region = FPlatformMemory::MapNamedSharedMemoryRegion(Name, false, FPlatformMemory::ESharedMemoryAccess::Read, size);
+	if (!segment->m_Region)
+	{
+		segment->m_Region = FPlatformMemory::MapNamedSharedMemoryRegion(Name, true, FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write, size);
+		if (!segment->m_Region)
+		{
+			return nullptr;
+		}
+
+		//Two processes may create the region at the same time, only one writes it.
+		FSharedContentHeader* header = (FSharedContentHeader*)segment->m_Region->GetAddress();
+		if (FPlatformAtomics::InterlockedCompareExchange(&header->m_State, Writing, Empty) == Empty)
+		{
+			segment->m_Base = (const uint8*)header;
+			segment->Write(Keys, Texts);
+			FPlatformAtomics::InterlockedExchange(&header->m_State, Ready);
+			segment->m_IsPublisher = true;
+		}
+	}
+
+	segment->m_Base = (const uint8*)segment->m_Region->GetAddress();
+	if (!segment->WaitUntilReady() || !segment->Matches(Keys))
+	{
+		return nullptr;
+	}
+	return segment;
+}
+
+FSharedContentSegment::~FSharedContentSegment()
+{
+	if (m_Region)
+	{
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(m_Region);
+	}
+}
+
+int32 FSharedContentSegment::Num() const
+{
+	return ((const FSharedContentHeader*)m_Base)->m_NumCaptions;
+}
+
+FStringView FSharedContentSegment::GetKey(int32 Id) const
+{
+	const FSharedContentHeader* header = (const FSharedContentHeader*)m_Base;
+	if (Id < 0 || Id >= header->m_NumCaptions)
+	{
+		return FStringView();
+	}
+	const FSharedCaption& caption = ((const FSharedCaption*)(m_Base + header->m_CaptionsOffset))[Id];
+	return FStringView((const TCHAR*)(m_Base + caption.m_KeyOffset), caption.m_KeyLength);
+}
+
+FStringView FSharedContentSegment::GetText(int32 Id) const
+{
+	const FSharedContentHeader* header = (const FSharedContentHeader*)m_Base;
+	if (Id < 0 || Id >= header->m_NumCaptions)
+	{
+		return FStringView();
+	}
+	const FSharedCaption& caption = ((const FSharedCaption*)(m_Base + header->m_CaptionsOffset))[Id];
+	return FStringView((const TCHAR*)(m_Base + caption.m_TextOffset), caption.m_TextLength);
+}
+
+//Returns the id of a caption key, or INDEX_NONE. Binary search
+//over the key hashes, the keys of equal hashes being compared.
+int32 FSharedContentSegment::FindId(FStringView Key) const
+{
+	const FSharedContentHeader* header = (const FSharedContentHeader*)m_Base;
+	const TArrayView<const FSharedKeyIndex> index((const FSharedKeyIndex*)(m_Base + header->m_IndexOffset), header->m_NumCaptions);
+	const uint32 hash = HashKey(Key);
+	for (int32 i = Algo::LowerBoundBy(index, hash, &FSharedKeyIndex::m_Hash); i < index.Num() && index[i].m_Hash == hash; i++)
+	{
+		if (GetKey(index[i].m_Id).Equals(Key, ESearchCase::CaseSensitive))
+		{
+			return index[i].m_Id;
+		}
+	}
+	return INDEX_NONE;
+}
+
+//Lays out the captions in the region, which is sized by ComputeSize.
+void FSharedContentSegment::Write(TArrayView<const FString> Keys, TArrayView<const FText> Texts)
+{
+	uint8* base = (uint8*)m_Base;
+	FSharedContentHeader* header = (FSharedContentHeader*)base;
+	header->m_Magic = Magic;
+	header->m_Version = Version;
+	header->m_CharSize = sizeof(TCHAR);
+	header->m_Size = (uint32)m_Size;
+	header->m_NumCaptions = Keys.Num();
+	header->m_CaptionsOffset = sizeof(FSharedContentHeader);
+	header->m_IndexOffset = header->m_CaptionsOffset + Keys.Num() * sizeof(FSharedCaption);
+	header->m_CharsOffset = header->m_IndexOffset + Keys.Num() * sizeof(FSharedKeyIndex);
+
+	FSharedCaption* captions = (FSharedCaption*)(base + header->m_CaptionsOffset);
+	FSharedKeyIndex* index = (FSharedKeyIndex*)(base + header->m_IndexOffset);
+	uint32 charsOffset = header->m_CharsOffset;
+	const auto writeChars = [base, &charsOffset](const FString& String, uint32& OutOffset, uint32& OutLength)
+	{
+		OutOffset = charsOffset;
+		OutLength = String.Len();
+		FMemory::Memcpy(base + charsOffset, *String, String.Len() * sizeof(TCHAR));
+		charsOffset += String.Len() * sizeof(TCHAR);
+	};
+
+	for (int i = 0; i < Keys.Num(); i++)
+	{
+		writeChars(Keys[i], captions[i].m_KeyOffset, captions[i].m_KeyLength);
+		writeChars(Texts[i].ToString(), captions[i].m_TextOffset, captions[i].m_TextLength);
+		index[i].m_Hash = HashKey(Keys[i]);
+		index[i].m_Id = i;
+	}
+	Algo::Sort(TArrayView<FSharedKeyIndex>(index, Keys.Num()), [](const FSharedKeyIndex& A, const FSharedKeyIndex& B)
+	{
+		return A.m_Hash != B.m_Hash ? A.m_Hash < B.m_Hash : A.m_Id < B.m_Id;
+	});
+	check(charsOffset == m_Size);
+}
+
+//Waits for the publisher to be done with the region.
+bool FSharedContentSegment::WaitUntilReady() const
+{
+	const double timeout = FPlatformTime::Seconds() + ReadyTimeout;
+	while (!HasRegionSize(m_Name, m_Size) || FPlatformAtomics::AtomicRead(&((const FSharedContentHeader*)m_Base)->m_State) != Ready)
+	{
+		if (FPlatformTime::Seconds() > timeout)
+		{
+			return false;
+		}
+		FPlatformProcess::Sleep(0.001f);
+	}
+	return true;
+}
+
+//Checks the layout version and that the region holds the given keys in
+//the same order, since the ids handed to the UI are the key positions.
+bool FSharedContentSegment::Matches(TArrayView<const FString> Keys) const
+{
+	const FSharedContentHeader* header = (const FSharedContentHeader*)m_Base;
+	if (header->m_Magic != Magic || header->m_Version != Version || header->m_CharSize != sizeof(TCHAR)
+		|| header->m_Size != m_Size || header->m_NumCaptions != Keys.Num())
+	{
+		return false;
+	}
+
+	for (int i = 0; i < Keys.Num(); i++)
+	{
+		if (!GetKey(i).Equals(Keys[i], ESearchCase::CaseSensitive))
+		{
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Caption keys and texts of the loaded content, published in a named shared
+//memory region so the game processes of a multi-screen installation that
+//load the same content keep a single copy. The first process writes the
+//region, the others map it read only. The layout only uses offsets from the
+//start of the region, so it reads the same wherever a process maps it.
+class COLDWARPROJECT_API FSharedContentSegment
+{
+public:
+	static constexpr uint32 Magic = 0x53504447; //GDPS
+	static constexpr uint16 Version = 1;
+
+	static TSharedPtr<FSharedContentSegment> Open(const FString& Name, TArrayView<const FString> Keys, TArrayView<const FText> Texts);
+	~FSharedContentSegment();
+
+	const FString& GetName() const { return m_Name; }
+	int32 Num() const;
+	FStringView GetKey(int32 Id) const;
+	FStringView GetText(int32 Id) const;
+	int32 FindId(FStringView Key) const;
+	SIZE_T GetSize() const { return m_Size; }
+	bool IsPublisher() const { return m_IsPublisher; }
+
+private:
+	FSharedContentSegment() = default;
+	void Write(TArrayView<const FString> Keys, TArrayView<const FText> Texts);
+	bool WaitUntilReady() const;
+	bool Matches(TArrayView<const FString> Keys) const;
+
+	FString m_Name;
+	FPlatformMemory::FSharedMemoryRegion* m_Region = nullptr;
+	const uint8* m_Base = nullptr;
+	SIZE_T m_Size = 0;
+	bool m_IsPublisher = false;
+};
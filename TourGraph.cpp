@@ -0,0 +1,244 @@
+#include "TourGraph.h"
+
+/*************************************
+Class: FTourGraph
+Author: Antoine Plouffe
+
+Description: Graph of a branching tour over the checkpoint indices. The
+successors are stored in a compact offset table, and the distances to the
+end of the tour, the next step on the shortest path and the reachability
+bitsets are computed once when the checkpoints are loaded.
+*************************************/
+
+//Builds the graph from the branching read in the checkpoints JSON file.
+//Entries line up with the checkpoints; a checkpoint without successors
+//leads to the next one, except the last one or one flagged as the end.
+//Returns false and fills the info message if a successor name is unknown.
+bool FTourGraph::Build(const FTourGraphData& GraphData, const TArray<int32>& FrameNumbers, FString& infoMessage)
+{
+	Reset();
+	const int32 numCheckpoints = FrameNumbers.Num();
+	bool success = true;
+	infoMessage = FString("Tour Graph Built");
+
+	TMap<FString, int32> nameToIndex;
+	for (int i = 0; i < GraphData.Data.Num() && i < numCheckpoints; i++)
+	{
+		nameToIndex.Add(GraphData.Data[i].CheckpointName, i);
+	}
+
+	m_SuccessorOffsets.Reserve(numCheckpoints + 1);
+	m_IsEnd.Init(false, numCheckpoints);
+	for (int i = 0; i < numCheckpoints; i++)
+	{
+		m_SuccessorOffsets.Add(m_Successors.Num());
+		const FTourGraphEntry* entry = GraphData.Data.IsValidIndex(i) ? &GraphData.Data[i] : nullptr;
+
+		if (entry && entry->NextCheckpointNames.Num() > 0)
+		{
+			for (const FString& nextName : entry->NextCheckpointNames)
+			{
+				if (const int32* nextIndex = nameToIndex.Find(nextName))
+				{
+					//Duplicates are only dropped among the successors of this checkpoint.
+					if (!MakeArrayView(m_Successors).RightChop(m_SuccessorOffsets[i]).Contains(*nextIndex))
+					{
+						m_Successors.Add(*nextIndex);
+					}
+				}
+				else
+				{
+					success = false;
+					infoMessage = FString::Printf(TEXT("Unknown Next Checkpoint %s"), *nextName);
+				}
+			}
+		}
+		else if (!(entry && entry->IsTourEnd) && i + 1 < numCheckpoints)
+		{
+			m_Successors.Add(i + 1);
+		}
+		m_IsEnd[i] = m_Successors.Num() == m_SuccessorOffsets[i];
+	}
+	m_SuccessorOffsets.Add(m_Successors.Num());
+
+	ComputeDistancesToEnd(FrameNumbers);
+	ComputeReachability();
+	return success;
+}
+
+void FTourGraph::Reset()
+{
+	m_SuccessorOffsets.Empty();
+	m_Successors.Empty();
+	m_IsEnd.Empty();
+	m_StepsToEnd.Empty();
+	m_FramesToEnd.Empty();
+	m_NextOnShortestPath.Empty();
+	m_Reachable.Empty();
+}
+
+//Returns the checkpoints the visitor can go to from the given checkpoint.
+TArrayView<const int32> FTourGraph::GetSuccessors(int32 CheckpointIndex) const
+{
+	if (CheckpointIndex < 0 || CheckpointIndex >= Num())
+	{
+		return TArrayView<const int32>();
+	}
+	const int32 offset = m_SuccessorOffsets[CheckpointIndex];
+	return TArrayView<const int32>(m_Successors.GetData() + offset, m_SuccessorOffsets[CheckpointIndex + 1] - offset);
+}
+
+//Returns the successor on the shortest path to the end, or INDEX_NONE.
+int32 FTourGraph::GetNextOnShortestPath(int32 CheckpointIndex) const
+{
+	return m_NextOnShortestPath.IsValidIndex(CheckpointIndex) ? m_NextOnShortestPath[CheckpointIndex] : INDEX_NONE;
+}
+
+//Returns the number of checkpoints left to the end of the
+//tour on the shortest path, or INDEX_NONE if it cannot end.
+int32 FTourGraph::GetStepsToEnd(int32 CheckpointIndex) const
+{
+	return m_StepsToEnd.IsValidIndex(CheckpointIndex) ? m_StepsToEnd[CheckpointIndex] : INDEX_NONE;
+}
+
+//Returns the number of camera frames left to the end of the tour
+//on the shortest path (in frames), or INDEX_NONE if it cannot end.
+int32 FTourGraph::GetFramesToEnd(int32 CheckpointIndex) const
+{
+	return m_FramesToEnd.IsValidIndex(CheckpointIndex) ? m_FramesToEnd[CheckpointIndex] : INDEX_NONE;
+}
+
+bool FTourGraph::CanReach(int32 FromCheckpointIndex, int32 ToCheckpointIndex) const
+{
+	return m_Reachable.IsValidIndex(FromCheckpointIndex) && ToCheckpointIndex >= 0 && ToCheckpointIndex < Num()
+		&& m_Reachable[FromCheckpointIndex][ToCheckpointIndex];
+}
+
+SIZE_T FTourGraph::GetAllocatedSize() const
+{
+	SIZE_T size = m_SuccessorOffsets.GetAllocatedSize() + m_Successors.GetAllocatedSize() + m_IsEnd.GetAllocatedSize()
+		+ m_StepsToEnd.GetAllocatedSize() + m_FramesToEnd.GetAllocatedSize() + m_NextOnShortestPath.GetAllocatedSize()
+		+ m_Reachable.GetAllocatedSize();
+	for (const TBitArray<>& reachable : m_Reachable)
+	{
+		size += reachable.GetAllocatedSize();
+	}
+	return size;
+}
+
+//Computes the remaining steps (breadth first search) and frames (Dijkstra,
+//weighted by the frame distance between checkpoints) from every checkpoint
+//to the closest end, walking the graph backward from the end checkpoints.
+void FTourGraph::ComputeDistancesToEnd(const TArray<int32>& FrameNumbers)
+{
+	const int32 numCheckpoints = Num();
+	m_StepsToEnd.Init(INDEX_NONE, numCheckpoints);
+	m_FramesToEnd.Init(INDEX_NONE, numCheckpoints);
+	m_NextOnShortestPath.Init(INDEX_NONE, numCheckpoints);
+
+	TArray<int32> predecessorOffsets;
+	TArray<int32> predecessors;
+	predecessorOffsets.Init(0, numCheckpoints + 1);
+	for (int32 successor : m_Successors)
+	{
+		predecessorOffsets[successor + 1]++;
+	}
+	for (int i = 0; i < numCheckpoints; i++)
+	{
+		predecessorOffsets[i + 1] += predecessorOffsets[i];
+	}
+	predecessors.SetNum(m_Successors.Num());
+	TArray<int32> fill = predecessorOffsets;
+	for (int i = 0; i < numCheckpoints; i++)
+	{
+		for (int32 successor : GetSuccessors(i))
+		{
+			predecessors[fill[successor]++] = i;
+		}
+	}
+
+	TArray<int32> queue;
+	queue.Reserve(numCheckpoints);
+	for (int i = 0; i < numCheckpoints; i++)
+	{
+		if (m_IsEnd[i])
+		{
+			m_StepsToEnd[i] = 0;
+			queue.Add(i);
+		}
+	}
+	for (int head = 0; head < queue.Num(); head++)
+	{
+		const int32 current = queue[head];
+		for (int p = predecessorOffsets[current]; p < predecessorOffsets[current + 1]; p++)
+		{
+			const int32 predecessor = predecessors[p];
+			if (m_StepsToEnd[predecessor] == INDEX_NONE)
+			{
+				m_StepsToEnd[predecessor] = m_StepsToEnd[current] + 1;
+				m_NextOnShortestPath[predecessor] = current;
+				queue.Add(predecessor);
+			}
+		}
+	}
+
+	typedef TPair<int32, int32> FFrameNode;
+	TArray<FFrameNode> heap;
+	for (int i = 0; i < numCheckpoints; i++)
+	{
+		if (m_IsEnd[i])
+		{
+			m_FramesToEnd[i] = 0;
+			heap.HeapPush(FFrameNode(0, i), [](const FFrameNode& A, const FFrameNode& B) { return A.Key < B.Key; });
+		}
+	}
+	while (heap.Num() > 0)
+	{
+		FFrameNode node;
+		heap.HeapPop(node, [](const FFrameNode& A, const FFrameNode& B) { return A.Key < B.Key; });
+		const int32 current = node.Value;
+		if (node.Key > m_FramesToEnd[current])
+		{
+			continue;
+		}
+		for (int p = predecessorOffsets[current]; p < predecessorOffsets[current + 1]; p++)
+		{
+			const int32 predecessor = predecessors[p];
+			const int32 frames = node.Key + FMath::Abs(FrameNumbers[current] - FrameNumbers[predecessor]);
+			if (m_FramesToEnd[predecessor] == INDEX_NONE || frames < m_FramesToEnd[predecessor])
+			{
+				m_FramesToEnd[predecessor] = frames;
+				heap.HeapPush(FFrameNode(frames, predecessor), [](const FFrameNode& A, const FFrameNode& B) { return A.Key < B.Key; });
+			}
+		}
+	}
+}
+
+//Computes, for every checkpoint, the bitset of the checkpoints reachable
+//from it. Successors usually come later in the file, so walking backward
+//converges in a single pass for most tours; loops take extra passes.
+void FTourGraph::ComputeReachability()
+{
+	const int32 numCheckpoints = Num();
+	m_Reachable.SetNum(numCheckpoints);
+	for (int i = 0; i < numCheckpoints; i++)
+	{
+		m_Reachable[i].Init(false, numCheckpoints);
+		m_Reachable[i][i] = true;
+	}
+
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (int i = numCheckpoints - 1; i >= 0; i--)
+		{
+			const int32 countBefore = m_Reachable[i].CountSetBits();
+			for (int32 successor : GetSuccessors(i))
+			{
+				m_Reachable[i].CombineWithBitwiseOR(m_Reachable[successor], EBitwiseOperatorFlags::MaintainSize);
+			}
+			changed |= m_Reachable[i].CountSetBits() != countBefore;
+		}
+	}
+}
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TourGraph.generated.h"
+
+//Optional branching of a checkpoint, read from the checkpoints JSON file.
+//A checkpoint without NextCheckpointNames leads to the next one in the file.
+USTRUCT()
+struct FTourGraphEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		FString CheckpointName;
+	UPROPERTY()
+		TArray<FString> NextCheckpointNames;
+	UPROPERTY()
+		bool IsTourEnd = false;
+};
+
+USTRUCT()
+struct FTourGraphData
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<FTourGraphEntry> Data;
+};
+
+//Tour described as a graph over the checkpoint indices. Everything the
+//controller asks while the tour runs (choices, next step on the shortest
+//path, remaining steps and frames, reachability) is precomputed at load
+//so each query is a table lookup.
+class COLDWARPROJECT_API FTourGraph
+{
+public:
+	bool Build(const FTourGraphData& GraphData, const TArray<int32>& FrameNumbers, FString& infoMessage);
+	void Reset();
+
+	int32 Num() const { return m_IsEnd.Num(); }
+	TArrayView<const int32> GetSuccessors(int32 CheckpointIndex) const;
+	bool IsBranching(int32 CheckpointIndex) const { return GetSuccessors(CheckpointIndex).Num() > 1; }
+	bool IsEnd(int32 CheckpointIndex) const { return m_IsEnd.IsValidIndex(CheckpointIndex) && m_IsEnd[CheckpointIndex]; }
+	int32 GetNextOnShortestPath(int32 CheckpointIndex) const;
+	int32 GetStepsToEnd(int32 CheckpointIndex) const;
+	int32 GetFramesToEnd(int32 CheckpointIndex) const;
+	bool CanReach(int32 FromCheckpointIndex, int32 ToCheckpointIndex) const;
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	void ComputeDistancesToEnd(const TArray<int32>& FrameNumbers);
+	void ComputeReachability();
+
+	TArray<int32> m_SuccessorOffsets;
+	TArray<int32> m_Successors;
+	TBitArray<> m_IsEnd;
+	TArray<int32> m_StepsToEnd;
+	TArray<int32> m_FramesToEnd;
+	TArray<int32> m_NextOnShortestPath;
+	TArray<TBitArray<>> m_Reachable;
+};
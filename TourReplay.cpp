@@ -0,0 +1,76 @@
+#include "TourReplay.h"
+#include "JsonObjectConverter.h"
+#include "Misc/FileHelper.h"
+
+/*************************************
+Class: FTourReplayRecorder
+Author: Antoine Plouffe
+
+Description: Script of the UGameData calls made during a tour, with the
+frame they were made at. Only the calls that depend on the visitor are
+recorded (loads, checkpoints, learn more and quiz), so a replay of the
+script repeats the same data work whatever the frame rate of the kiosk.
+*************************************/
+
+void FTourReplayRecorder::Start(const FString& FilePath)
+{
+	m_FilePath = FilePath;
+	m_Script = FTourReplayScript();
+	m_FirstFrame = GFrameCounter;
+}
+
+void FTourReplayRecorder::Record(ETourReplayAction Action, int32 Index, int32 Option, const FString& Path, int32 Seed)
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+	FTourReplayEvent& event = m_Script.Events.AddDefaulted_GetRef();
+	event.Frame = (int32)(GFrameCounter - m_FirstFrame);
+	event.Action = Action;
+	event.Path = Path;
+	event.Index = Index;
+	event.Option = Option;
+	event.Seed = Seed;
+}
+
+//Writes the script recorded so far. The recording goes on, so the
+//next tour is appended to the same script.
+bool FTourReplayRecorder::Save(FString& infoMessage)
+{
+	FString jsonString;
+	if (!FJsonObjectConverter::UStructToJsonObjectString(m_Script, jsonString) || !FFileHelper::SaveStringToFile(jsonString, *m_FilePath))
+	{
+		infoMessage = FString::Printf(TEXT("Could Not Write Tour Replay %s"), *m_FilePath);
+		return false;
+	}
+	infoMessage = FString("Tour Replay Written");
+	return true;
+}
+
+FTourReplayTiming FTourReplayReport::MakeTiming(const FString& Name, TArray<double> Seconds)
+{
+	FTourReplayTiming timing;
+	timing.Name = Name;
+	timing.Count = Seconds.Num();
+	if (Seconds.Num() == 0)
+	{
+		return timing;
+	}
+
+	Seconds.Sort();
+	double total = 0.0;
+	for (double seconds : Seconds)
+	{
+		total += seconds;
+	}
+	timing.AverageMs = total / Seconds.Num() * 1000.0;
+	timing.P95Ms = Seconds[FMath::Min(FMath::CeilToInt(Seconds.Num() * 0.95) - 1, Seconds.Num() - 1)] * 1000.0;
+	timing.MaxMs = Seconds.Last() * 1000.0;
+	return timing;
+}
+
+const FTourReplayTiming* FTourReplayReport::FindLoader(const FString& Name) const
+{
+	return Loaders.FindByPredicate([&Name](const FTourReplayTiming& timing) { return timing.Name == Name; });
+}
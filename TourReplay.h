@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TourReplay.generated.h"
+
+UENUM()
+enum class ETourReplayAction : uint8
+{
+	LoadInstructions,
+	LoadCheckpoints,
+	CheckpointReached,
+	OpenLearnMore,
+	CompleteLearnMore,
+	ShowQuizQuestion,
+	AnswerQuiz,
+	LoadQuizQuestions,
+	OpenQuizBank,
+	LoadQuizSample,
+};
+
+//Call made to UGameData during a tour, at a frame relative to the first one.
+USTRUCT()
+struct FTourReplayEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		int32 Frame = 0;
+	UPROPERTY()
+		ETourReplayAction Action = ETourReplayAction::LoadInstructions;
+	UPROPERTY()
+		FString Path;
+	UPROPERTY()
+		int32 Index = INDEX_NONE;
+	UPROPERTY()
+		int32 Option = INDEX_NONE;
+	UPROPERTY()
+		int32 Seed = 0;
+};
+
+//Input script of a tour, recorded on a kiosk and replayed by the
+//TourReplay commandlet at a fixed frame time.
+USTRUCT()
+struct FTourReplayScript
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		float FrameTime = 1.0f / 60.0f;
+	UPROPERTY()
+		TArray<FTourReplayEvent> Events;
+};
+
+USTRUCT()
+struct FTourReplayTiming
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		FString Name;
+	UPROPERTY()
+		int32 Count = 0;
+	UPROPERTY()
+		double AverageMs = 0.0;
+	UPROPERTY()
+		double P95Ms = 0.0;
+	UPROPERTY()
+		double MaxMs = 0.0;
+};
+
+//Result of a replay: the game thread time of the frames and the latency of
+//each UGameData call. Saved as JSON and used as the baseline of later runs.
+USTRUCT()
+struct FTourReplayReport
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		FTourReplayTiming Frames;
+	UPROPERTY()
+		TArray<FTourReplayTiming> Loaders;
+
+	static FTourReplayTiming MakeTiming(const FString& Name, TArray<double> Seconds);
+	const FTourReplayTiming* FindLoader(const FString& Name) const;
+};
+
+//Records the UGameData calls of a tour when the game is started with
+//-RecordTourReplay=<file>. The script is saved when the tour is completed.
+class COLDWARPROJECT_API FTourReplayRecorder
+{
+public:
+	void Start(const FString& FilePath);
+	bool IsRecording() const { return !m_FilePath.IsEmpty(); }
+	void Record(ETourReplayAction Action, int32 Index = INDEX_NONE, int32 Option = INDEX_NONE, const FString& Path = FString(), int32 Seed = 0);
+	bool Save(FString& infoMessage);
+
+private:
+	FString m_FilePath;
+	FTourReplayScript m_Script;
+	uint64 m_FirstFrame = 0;
+};
@@ -0,0 +1,288 @@
+#include "TourReplayCommandlet.h"
+#include "TourReplay.h"
+#include "GameData.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Components/HorizontalBox.h"
+#include "Engine/Level.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "JsonObjectConverter.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Sound/SoundBase.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogTourReplay, Log, All);
+
+/*************************************
+Class: UTourReplayCommandlet
+Author: Antoine Plouffe
+
+Description: Deterministic replay of a recorded tour, to track the frame
+time of the data layer without a GPU. The events of the script are applied
+at their frame and the instruction scheduler is advanced by the fixed frame
+time of the script, so every run does the same work. Each run starts from a
+new UGameData with an empty parse cache, like a kiosk starting a tour after
+a content update; the parse cache and the session record of the run live in
+Saved/TourReplay/Scratch, so the files of the kiosk are left alone.
+*************************************/
+
+namespace
+{
+	//Content the loaders resolve names against: the sounds and
+	//images under the given paths and the checkpoints of the map.
+	struct FReplayContent
+	{
+		TArray<USoundBase*> m_Sounds;
+		TArray<UTexture2D*> m_Images;
+		TArray<AActor*> m_Checkpoints;
+		UWorld* m_World = nullptr;
+	};
+
+	void LoadReplayContent(const FString& MapPackage, const FString& AssetPaths, FReplayContent& OutContent)
+	{
+		if (!MapPackage.IsEmpty())
+		{
+			UPackage* package = LoadPackage(nullptr, *MapPackage, LOAD_None);
+			OutContent.m_World = package ? UWorld::FindWorldInPackage(package) : nullptr;
+			if (OutContent.m_World && OutContent.m_World->PersistentLevel)
+			{
+				for (AActor* actor : OutContent.m_World->PersistentLevel->Actors)
+				{
+					if (actor && actor->Tags.Num() > 0)
+					{
+						OutContent.m_Checkpoints.Add(actor);
+					}
+				}
+			}
+			else
+			{
+				UE_LOG(LogTourReplay, Warning, TEXT("Map Not Found %s"), *MapPackage);
+			}
+		}
+
+		IAssetRegistry& assetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+		assetRegistry.SearchAllAssets(true);
+		TArray<FString> paths;
+		AssetPaths.ParseIntoArray(paths, TEXT("+"));
+		for (const FString& path : paths)
+		{
+			TArray<FAssetData> assets;
+			assetRegistry.GetAssetsByPath(FName(*path), assets, true);
+			for (const FAssetData& asset : assets)
+			{
+				if (asset.IsInstanceOf(USoundBase::StaticClass()))
+				{
+					OutContent.m_Sounds.Add(Cast<USoundBase>(asset.GetAsset()));
+				}
+				else if (asset.IsInstanceOf(UTexture2D::StaticClass()))
+				{
+					OutContent.m_Images.Add(Cast<UTexture2D>(asset.GetAsset()));
+				}
+			}
+		}
+	}
+
+	class FReplayRun
+	{
+	public:
+		FReplayRun(const FReplayContent& Content, const FString& ScratchDir, TMap<FString, TArray<double>>& LoaderTimes)
+			: m_Content(Content), m_LoaderTimes(LoaderTimes)
+		{
+			m_GameData = NewObject<UGameData>();
+			m_GameData->AddToRoot();
+			m_GameData->GameData();
+			m_GameData->UseScratchDir(ScratchDir);
+			m_ProgressBarsBox = NewObject<UHorizontalBox>();
+			m_ProgressBarsBox->AddToRoot();
+		}
+
+		~FReplayRun()
+		{
+			m_ProgressBarsBox->RemoveFromRoot();
+			m_GameData->RemoveFromRoot();
+		}
+
+		void Apply(const FTourReplayEvent& Event)
+		{
+			switch (Event.Action)
+			{
+			case ETourReplayAction::LoadInstructions:
+				Time(TEXT("LoadInstructionsData"), [&]() { m_GameData->LoadInstructionsData(m_Content.m_World, Event.Path, m_Content.m_Sounds); });
+				break;
+			case ETourReplayAction::LoadCheckpoints:
+				Time(TEXT("LoadCheckpointsData"), [&]() { m_GameData->LoadCheckpointsData(m_Content.m_World, Event.Path, m_Content.m_Sounds, m_Content.m_Checkpoints); });
+				break;
+			case ETourReplayAction::CheckpointReached:
+				Time(TEXT("MarkCheckpointReached"), [&]() { m_GameData->MarkCheckpointReached(Event.Index); });
+				break;
+			case ETourReplayAction::OpenLearnMore:
+			{
+				int32 numLearnMore = 0;
+				Time(TEXT("PopulateLearnMoreUI"), [&]() { numLearnMore = m_GameData->PopulateLearnMoreUI(Event.Path, Event.Index, m_Content.m_Sounds, m_Content.m_Images).LearnMoreData.Num(); });
+				m_ProgressBarsBox->ClearChildren();
+				Time(TEXT("LoadLearnMoreProgressBar"), [&]() { m_GameData->LoadLearnMoreProgressBar(m_ProgressBarsBox, FProgressBarStyle(), numLearnMore); });
+				break;
+			}
+			case ETourReplayAction::CompleteLearnMore:
+				Time(TEXT("MarkLearnMoreCompleted"), [&]() { m_GameData->MarkLearnMoreCompleted(Event.Index); });
+				break;
+			case ETourReplayAction::LoadQuizQuestions:
+				Time(TEXT("LoadQuizQuestions"), [&]() { m_QuizQuestions = m_GameData->LoadQuizQuestions(); });
+				break;
+			case ETourReplayAction::OpenQuizBank:
+				Time(TEXT("OpenQuizQuestionBank"), [&]() { m_GameData->OpenQuizQuestionBank(Event.Path); });
+				break;
+			case ETourReplayAction::LoadQuizSample:
+			{
+				FRandomStream randomStream(Event.Seed);
+				Time(TEXT("LoadQuizQuestionsSample"), [&]() { m_QuizQuestions = m_GameData->LoadQuizQuestionsSample(Event.Index, randomStream, Event.Option); });
+				break;
+			}
+			case ETourReplayAction::ShowQuizQuestion:
+				//Scripts recorded before the quiz loads were recorded show
+				//questions of quiz.json.
+				if (m_QuizQuestions.m_Questions.Num() == 0)
+				{
+					Time(TEXT("LoadQuizQuestions"), [&]() { m_QuizQuestions = m_GameData->LoadQuizQuestions(); });
+				}
+				if (m_QuizQuestions.m_Questions.IsValidIndex(Event.Index))
+				{
+					Time(TEXT("PopulateQuizUI"), [&]() { m_GameData->PopulateQuizUI(m_Content.m_Sounds, m_QuizQuestions, Event.Index); });
+				}
+				break;
+			case ETourReplayAction::AnswerQuiz:
+				Time(TEXT("MarkQuizAnswered"), [&]() { m_GameData->MarkQuizAnswered(Event.Index, Event.Option); });
+				break;
+			}
+		}
+
+		void Advance(float DeltaTime)
+		{
+			m_GameData->GetInstructionScheduler().Advance(DeltaTime);
+		}
+
+	private:
+		template<typename TCall>
+		void Time(const TCHAR* LoaderName, TCall Call)
+		{
+			const double startTime = FPlatformTime::Seconds();
+			Call();
+			m_LoaderTimes.FindOrAdd(LoaderName).Add(FPlatformTime::Seconds() - startTime);
+		}
+
+		const FReplayContent& m_Content;
+		TMap<FString, TArray<double>>& m_LoaderTimes;
+		UGameData* m_GameData;
+		UHorizontalBox* m_ProgressBarsBox;
+		FQuizQuestions m_QuizQuestions;
+	};
+
+	//Compares the average and 95th percentile of a timing with the
+	//baseline. Differences under a tenth of a millisecond are ignored,
+	//since they are in the noise of a headless run.
+	bool CompareTiming(const FTourReplayTiming& Timing, const FTourReplayTiming* Baseline, float Tolerance)
+	{
+		if (!Baseline)
+		{
+			UE_LOG(LogTourReplay, Display, TEXT("%-26s avg %8.3f ms  p95 %8.3f ms  max %8.3f ms  (no baseline)"), *Timing.Name, Timing.AverageMs, Timing.P95Ms, Timing.MaxMs);
+			return true;
+		}
+
+		const auto isSlower = [Tolerance](double Value, double BaselineValue) { return Value > BaselineValue * (1.0 + Tolerance) && Value - BaselineValue > 0.1; };
+		const bool isRegression = isSlower(Timing.AverageMs, Baseline->AverageMs) || isSlower(Timing.P95Ms, Baseline->P95Ms);
+		UE_LOG(LogTourReplay, Display, TEXT("%-26s avg %8.3f ms (%8.3f)  p95 %8.3f ms (%8.3f)  max %8.3f ms (%8.3f)%s"), *Timing.Name,
+			Timing.AverageMs, Baseline->AverageMs, Timing.P95Ms, Baseline->P95Ms, Timing.MaxMs, Baseline->MaxMs, isRegression ? TEXT("  REGRESSION") : TEXT(""));
+		return !isRegression;
+	}
+}
+
+UTourReplayCommandlet::UTourReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UTourReplayCommandlet::Main(const FString& Params)
+{
+	FString scriptPath;
+	FString mapPackage;
+	FString assetPaths = TEXT("/Game");
+	FString outputPath = FPaths::ProjectSavedDir() / TEXT("TourReplay") / TEXT("Report.json");
+	const FString scratchDir = FPaths::ProjectSavedDir() / TEXT("TourReplay") / TEXT("Scratch");
+	FString baselinePath;
+	int32 runs = 5;
+	float tolerance = 0.2f;
+	FParse::Value(*Params, TEXT("Script="), scriptPath);
+	FParse::Value(*Params, TEXT("Map="), mapPackage);
+	FParse::Value(*Params, TEXT("Assets="), assetPaths);
+	FParse::Value(*Params, TEXT("Output="), outputPath);
+	FParse::Value(*Params, TEXT("Baseline="), baselinePath);
+	FParse::Value(*Params, TEXT("Runs="), runs);
+	FParse::Value(*Params, TEXT("Tolerance="), tolerance);
+
+	FString jsonString;
+	FTourReplayScript script;
+	if (!FFileHelper::LoadFileToString(jsonString, *scriptPath) || !FJsonObjectConverter::JsonObjectStringToUStruct(jsonString, &script))
+	{
+		UE_LOG(LogTourReplay, Error, TEXT("Invalid Tour Replay %s"), *scriptPath);
+		return 1;
+	}
+	script.Events.StableSort([](const FTourReplayEvent& A, const FTourReplayEvent& B) { return A.Frame < B.Frame; });
+	const int32 numFrames = script.Events.Num() > 0 ? script.Events.Last().Frame + 1 : 0;
+
+	FReplayContent content;
+	LoadReplayContent(mapPackage, assetPaths, content);
+
+	TArray<double> frameTimes;
+	frameTimes.Reserve(numFrames * runs);
+	TMap<FString, TArray<double>> loaderTimes;
+	for (int run = 0; run < runs; run++)
+	{
+		FReplayRun replayRun(content, scratchDir, loaderTimes);
+		int32 eventIndex = 0;
+		for (int32 frame = 0; frame < numFrames; frame++)
+		{
+			const double startTime = FPlatformTime::Seconds();
+			while (eventIndex < script.Events.Num() && script.Events[eventIndex].Frame == frame)
+			{
+				replayRun.Apply(script.Events[eventIndex++]);
+			}
+			replayRun.Advance(script.FrameTime);
+			frameTimes.Add(FPlatformTime::Seconds() - startTime);
+		}
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	FTourReplayReport report;
+	report.Frames = FTourReplayReport::MakeTiming(TEXT("Frames"), MoveTemp(frameTimes));
+	for (auto& loader : loaderTimes)
+	{
+		report.Loaders.Add(FTourReplayReport::MakeTiming(loader.Key, MoveTemp(loader.Value)));
+	}
+	report.Loaders.Sort([](const FTourReplayTiming& A, const FTourReplayTiming& B) { return A.Name < B.Name; });
+
+	FTourReplayReport baseline;
+	const bool hasBaseline = !baselinePath.IsEmpty() && FFileHelper::LoadFileToString(jsonString, *baselinePath)
+		&& FJsonObjectConverter::JsonObjectStringToUStruct(jsonString, &baseline);
+	if (!baselinePath.IsEmpty() && !hasBaseline)
+	{
+		UE_LOG(LogTourReplay, Warning, TEXT("Invalid Baseline %s"), *baselinePath);
+	}
+
+	UE_LOG(LogTourReplay, Display, TEXT("%d events, %d frames, %d runs"), script.Events.Num(), numFrames, runs);
+	bool isPassing = CompareTiming(report.Frames, hasBaseline ? &baseline.Frames : nullptr, tolerance);
+	for (const FTourReplayTiming& loader : report.Loaders)
+	{
+		isPassing &= CompareTiming(loader, hasBaseline ? baseline.FindLoader(loader.Name) : nullptr, tolerance);
+	}
+
+	if (!FJsonObjectConverter::UStructToJsonObjectString(report, jsonString) || !FFileHelper::SaveStringToFile(jsonString, *outputPath))
+	{
+		UE_LOG(LogTourReplay, Error, TEXT("Could not write %s"), *outputPath);
+		return 1;
+	}
+
+	return isPassing ? 0 : 1;
+}
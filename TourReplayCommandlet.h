@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TourReplayCommandlet.generated.h"
+
+//Replays a tour script recorded with -RecordTourReplay through UGameData at
+//a fixed frame time, without rendering, and reports the game thread time of
+//the frames and the latency of each loader. With a baseline report, fails
+//when a timing is slower than the baseline by more than the tolerance.
+//
+//Usage: UnrealEditor-Cmd ColdWarProject -run=TourReplay -nullrhi -Script=<file>
+//	[-Map=/Game/Maps/A] [-Assets=/Game/Sounds+/Game/Images] [-Runs=5]
+//	[-Output=<file>] [-Baseline=<file>] [-Tolerance=0.2]
+UCLASS()
+class COLDWARPROJECT_API UTourReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UTourReplayCommandlet();
+	virtual int32 Main(const FString& Params) override;
+};